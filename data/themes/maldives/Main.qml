@@ -146,6 +146,8 @@ Rectangle {
 
                         KeyNavigation.backtab: name; KeyNavigation.tab: session
 
+                        onActiveFocusChanged: if (activeFocus) sddm.prepareLogin(name.text)
+
                         Keys.onPressed: {
                             if (event.key === Qt.Key_Return || event.key === Qt.Key_Enter) {
                                 sddm.login(name.text, password.text, session.index)
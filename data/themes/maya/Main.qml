@@ -490,6 +490,8 @@ Rectangle {
         KeyNavigation.tab     : maya_login
         KeyNavigation.backtab : maya_username
 
+        onActiveFocusChanged: if (activeFocus) sddm.prepareLogin(maya_username.text)
+
         Keys.onPressed: {
           if ((event.key === Qt.Key_Return) || (event.key === Qt.Key_Enter)) {
             maya_root.tryLogin()
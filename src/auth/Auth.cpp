@@ -21,8 +21,12 @@
 #include "Auth.h"
 #include "Constants.h"
 #include "AuthMessages.h"
-#include "SafeDataStream.h"
+#include "HelperPool.h"
+#include "LoggingCategories.h"
+#include "SafeDataChannel.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
 #include <QtCore/QProcess>
 #include <QtCore/QUuid>
 #include <QtNetwork/QLocalServer>
@@ -37,6 +41,7 @@ namespace SDDM {
         Q_OBJECT
     public slots:
         void handleNewConnection();
+        void handleHello(const QByteArray &message);
     public:
         static SocketServer *instance();
 
@@ -53,21 +58,31 @@ namespace SDDM {
     public:
         Private(Auth *parent);
         ~Private();
-        void setSocket(QLocalSocket *socket);
+        void setChild(QProcess *process);
+        void setChannel(SafeDataChannel *channel);
+        void send(const QByteArray &data);
+        void sendAuthenticated();
     public slots:
-        void dataPending();
+        void dataPending(const QByteArray &message);
         void childExited(int exitCode, QProcess::ExitStatus exitStatus);
         void childError(QProcess::ProcessError error);
         void requestFinished();
     public:
         AuthRequest *request { nullptr };
         QProcess *child { nullptr };
-        QLocalSocket *socket { nullptr };
+        QPointer<SafeDataChannel> channel { };
+        QPointer<HelperPool> pool { };
+        QElapsedTimer startTimer { };
+        bool pooled { false };
         QString sessionPath { };
         QString user { };
         QString cookie { };
         bool autologin { false };
         bool greeter { false };
+        bool rendezvous { false };
+        bool held { false };
+        bool authenticated { false };
+        LoginTrace trace { };
         QProcessEnvironment environment { };
         qint64 id { 0 };
         static qint64 lastId;
@@ -84,17 +99,34 @@ namespace SDDM {
 
     void Auth::SocketServer::handleNewConnection()  {
         while (hasPendingConnections()) {
-            Msg m = Msg::MSG_UNKNOWN;
-            qint64 id;
             QLocalSocket *socket = nextPendingConnection();
-            SafeDataStream str(socket);
-            str.receive();
-            str >> m >> id;
-            if (m == Msg::HELLO && id && SocketServer::instance()->helpers.contains(id)) {
-                helpers[id]->setSocket(socket);
-                if (socket->bytesAvailable() > 0)
-                    helpers[id]->dataPending();
-            }
+            connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+
+            // wait for the greeting without blocking the event loop
+            SafeDataChannel *channel = new SafeDataChannel(socket, socket);
+            connect(channel, SIGNAL(messageReceived(QByteArray)), this, SLOT(handleHello(QByteArray)));
+            if (socket->bytesAvailable() > 0)
+                channel->readPending();
+        }
+    }
+
+    void Auth::SocketServer::handleHello(const QByteArray &message) {
+        SafeDataChannel *channel = qobject_cast<SafeDataChannel *>(sender());
+        if (!channel)
+            return;
+
+        // only the first message is ours, the rest belongs to the helper's Auth
+        disconnect(channel, SIGNAL(messageReceived(QByteArray)), this, SLOT(handleHello(QByteArray)));
+
+        Msg m = Msg::MSG_UNKNOWN;
+        qint64 id = 0;
+        QDataStream str(message);
+        str >> m >> id;
+        if (m == Msg::HELLO && id && helpers.contains(id)) {
+            helpers[id]->setChannel(channel);
+        } else {
+            qCWarning(SDDM_AUTH) << "Auth: Unexpected greeting from a helper, dropping the connection";
+            channel->device()->close();
         }
     }
 
@@ -112,25 +144,6 @@ namespace SDDM {
             , request(new AuthRequest(parent))
             , child(new QProcess(this))
             , id(lastId++) {
-        SocketServer::instance()->helpers[id] = this;
-        QProcessEnvironment env = child->processEnvironment();
-        bool langEmpty = true;
-        QFile localeFile(QStringLiteral("/etc/locale.conf"));
-        if (localeFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&localeFile);
-            while (!in.atEnd()) {
-                QStringList parts = in.readLine().split(QLatin1Char('='));
-                if (parts.size() >= 2) {
-                    env.insert(parts[0], parts[1]);
-                    if (parts[0] == QLatin1String("LANG"))
-                        langEmpty = false;
-                }
-            }
-            localeFile.close();
-        }
-        if (langEmpty)
-            env.insert(QStringLiteral("LANG"), QStringLiteral("C"));
-        child->setProcessEnvironment(env);
         connect(child, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(childExited(int,QProcess::ExitStatus)));
         connect(child, SIGNAL(error(QProcess::ProcessError)), this, SLOT(childError(QProcess::ProcessError)));
         connect(request, SIGNAL(finished()), this, SLOT(requestFinished()));
@@ -139,21 +152,53 @@ namespace SDDM {
 
     Auth::Private::~Private()
     {
-        SocketServer::instance()->helpers.remove(id);
+        if (rendezvous)
+            SocketServer::instance()->helpers.remove(id);
     }
 
 
-    void Auth::Private::setSocket(QLocalSocket *socket) {
-        this->socket = socket;
-        connect(socket, SIGNAL(readyRead()), this, SLOT(dataPending()));
+    void Auth::Private::setChild(QProcess *process) {
+        // the one we created ourselves was never started
+        child->disconnect(this);
+        child->deleteLater();
+
+        child = process;
+        child->setParent(this);
+        connect(child, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(childExited(int,QProcess::ExitStatus)));
+        connect(child, SIGNAL(error(QProcess::ProcessError)), this, SLOT(childError(QProcess::ProcessError)));
     }
 
-    void Auth::Private::dataPending() {
+    void Auth::Private::setChannel(SafeDataChannel *channel) {
+        this->channel = channel;
+        connect(channel, SIGNAL(messageReceived(QByteArray)), this, SLOT(dataPending(QByteArray)));
+    }
+
+    void Auth::Private::send(const QByteArray &data) {
+        if (!channel) {
+            qCWarning(SDDM_AUTH) << "Auth: sddm-helper is not connected, dropping message";
+            return;
+        }
+        channel->send(data);
+    }
+
+    void Auth::Private::sendAuthenticated() {
+        QByteArray reply;
+        QDataStream out(&reply, QIODevice::WriteOnly);
+        out << AUTHENTICATED << environment << cookie << sessionPath;
+        send(reply);
+    }
+
+    void Auth::Private::dataPending(const QByteArray &message) {
         Auth *auth = qobject_cast<Auth*>(parent());
         Msg m = MSG_UNKNOWN;
-        SafeDataStream str(socket);
-        str.receive();
+        QDataStream str(message);
         str >> m;
+
+        if (startTimer.isValid()) {
+            qCDebug(SDDM_AUTH) << "Auth: First message from" << (pooled ? "pooled" : "newly started")
+                     << "sddm-helper after" << startTimer.elapsed() << "ms";
+            startTimer.invalidate();
+        }
         switch (m) {
             case ERROR: {
                 QString message;
@@ -175,15 +220,29 @@ namespace SDDM {
                 request->setRequest(&r);
                 break;
             }
+            case TRACE: {
+                quint64 loginId = 0;
+                QString phase;
+                qint64 timestamp = 0;
+                str >> loginId >> phase >> timestamp;
+                if (loginId == trace.id())
+                    trace.mark(phase, timestamp);
+                break;
+            }
             case AUTHENTICATED: {
+                trace.mark(QStringLiteral("AUTHENTICATED"));
+                // the pool held back the replacement of our helper until now
+                if (pooled && pool)
+                    pool->loginSettled();
                 QString user;
                 str >> user;
                 if (!user.isEmpty()) {
                     auth->setUser(user);
                     Q_EMIT auth->authentication(user, true);
-                    str.reset();
-                    str << AUTHENTICATED << environment << cookie;
-                    str.send();
+                    // a held helper waits for the reply, that's when it opens the session
+                    authenticated = true;
+                    if (!held)
+                        sendAuthenticated();
                 }
                 else {
                     Q_EMIT auth->authentication(user, false);
@@ -191,12 +250,14 @@ namespace SDDM {
                 break;
             }
             case SESSION_STATUS: {
+                trace.mark(QStringLiteral("SESSION_STATUS"));
                 bool status;
                 str >> status;
                 Q_EMIT auth->session(status);
-                str.reset();
-                str << SESSION_STATUS;
-                str.send();
+                QByteArray reply;
+                QDataStream out(&reply, QIODevice::WriteOnly);
+                out << SESSION_STATUS;
+                send(reply);
                 break;
             }
             default: {
@@ -206,15 +267,18 @@ namespace SDDM {
     }
 
     void Auth::Private::childExited(int exitCode, QProcess::ExitStatus exitStatus) {
+        if (pooled && pool)
+            pool->loginSettled();
+
         if (exitStatus != QProcess::NormalExit) {
-            qWarning("Auth: sddm-helper crashed (exit code %d)", exitCode);
+            qCWarning(SDDM_AUTH, "Auth: sddm-helper crashed (exit code %d)", exitCode);
             Q_EMIT qobject_cast<Auth*>(parent())->error(child->errorString(), ERROR_INTERNAL);
         }
 
         if (exitCode == HELPER_SUCCESS)
-            qDebug() << "Auth: sddm-helper exited successfully";
+            qCDebug(SDDM_AUTH) << "Auth: sddm-helper exited successfully";
         else
-            qWarning("Auth: sddm-helper exited with %d", exitCode);
+            qCWarning(SDDM_AUTH, "Auth: sddm-helper exited with %d", exitCode);
 
         Q_EMIT qobject_cast<Auth*>(parent())->finished((Auth::HelperExitStatus)exitCode);
     }
@@ -225,10 +289,11 @@ namespace SDDM {
     }
 
     void Auth::Private::requestFinished() {
-        SafeDataStream str(socket);
+        QByteArray data;
+        QDataStream str(&data, QIODevice::WriteOnly);
         Request r = request->request();
         str << REQUEST << r;
-        str.send();
+        send(data);
         request->setRequest();
     }
 
@@ -340,10 +405,63 @@ namespace SDDM {
         }
     }
 
+    void Auth::setHelperPool(HelperPool *pool) {
+        d->pool = pool;
+    }
+
+    void Auth::setLoginTrace(const LoginTrace &trace) {
+        d->trace = trace;
+    }
+
+    const LoginTrace &Auth::loginTrace() const {
+        return d->trace;
+    }
+
+    void Auth::setSessionHeld(bool on) {
+        d->held = on;
+    }
+
+    bool Auth::isSessionHeld() const {
+        return d->held;
+    }
+
+    bool Auth::isAuthenticated() const {
+        return d->authenticated;
+    }
+
+    void Auth::releaseSession() {
+        if (!d->held)
+            return;
+        d->held = false;
+        d->trace.mark(QStringLiteral("Auth::releaseSession"));
+        if (d->authenticated)
+            d->sendAuthenticated();
+    }
+
     void Auth::start() {
+        d->startTimer.start();
+        d->authenticated = false;
+        d->trace.mark(QStringLiteral("Auth::start"));
+
+        // take over a warm helper and just tell it what to do, as long as
+        // its output goes where ours would
+        QProcess *process = nullptr;
+        SafeDataChannel *channel = nullptr;
+        if (d->pool && d->child->processChannelMode() == HelperPool::processChannelMode() &&
+                d->pool->claim(&process, &channel)) {
+            d->pooled = true;
+            d->setChild(process);
+            channel->device()->setParent(d);
+            d->setChannel(channel);
+
+            QByteArray data;
+            QDataStream str(&data, QIODevice::WriteOnly);
+            str << START << d->sessionPath << d->user << d->autologin << d->greeter << d->trace.id();
+            d->send(data);
+            return;
+        }
+
         QStringList args;
-        args << QStringLiteral("--socket") << SocketServer::instance()->fullServerName();
-        args << QStringLiteral("--id") << QStringLiteral("%1").arg(d->id);
         if (!d->sessionPath.isEmpty())
             args << QStringLiteral("--start") << d->sessionPath;
         if (!d->user.isEmpty())
@@ -352,7 +470,27 @@ namespace SDDM {
             args << QStringLiteral("--autologin");
         if (d->greeter)
             args << QStringLiteral("--greeter");
-        d->child->start(QStringLiteral("%1/sddm-helper").arg(QStringLiteral(LIBEXEC_INSTALL_DIR)), args);
+        if (d->trace.id())
+            args << QStringLiteral("--login-id") << QString::number(d->trace.id());
+
+        // picked up here rather than in the constructor, Auth objects live
+        // for as long as their display
+        d->child->setProcessEnvironment(HelperPool::processEnvironment());
+
+        // hand the helper its end of a socket pair so it doesn't have to
+        // find its way back to us through the rendezvous socket
+        channel = HelperPool::startHelper(d->child, args, d);
+        if (channel) {
+            d->setChannel(channel);
+            return;
+        }
+
+        qCWarning(SDDM_AUTH) << "Auth: Using the rendezvous socket";
+        d->rendezvous = true;
+        SocketServer::instance()->helpers[d->id] = d;
+        args << QStringLiteral("--socket") << SocketServer::instance()->fullServerName();
+        args << QStringLiteral("--id") << QStringLiteral("%1").arg(d->id);
+        d->child->start(HelperPool::helperPath(), args);
     }
 }
 
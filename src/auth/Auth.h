@@ -23,11 +23,14 @@
 
 #include "AuthRequest.h"
 #include "AuthPrompt.h"
+#include "LoginTrace.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QProcessEnvironment>
 
 namespace SDDM {
+    class HelperPool;
+
     /**
     * \brief
     * Main class triggering the authentication and handling all communication
@@ -147,6 +150,40 @@ namespace SDDM {
          */
         void setCookie(const QString &cookie);
 
+        /**
+         * Use an already running helper from the pool if there is one
+         * @param pool pool to claim the helper from
+         */
+        void setHelperPool(HelperPool *pool);
+
+        /**
+         * Record the phases of the next authentication into this trace,
+         * the helper reports its own phases under the same login id
+         * @param trace trace started when the login was requested
+         */
+        void setLoginTrace(const LoginTrace &trace);
+        const LoginTrace &loginTrace() const;
+
+        /**
+         * Keep the helper waiting after a successful authentication instead of
+         * letting it open the session, until \ref releaseSession is called.
+         * The environment may still be changed while the session is held.
+         * @param on true to hold the session
+         */
+        void setSessionHeld(bool on);
+        bool isSessionHeld() const;
+
+        /**
+         * True once the helper has authenticated the user of the current run
+         */
+        bool isAuthenticated() const;
+
+        /**
+         * Let a held helper go on and open the session, right away if it has
+         * already authenticated or as soon as it does
+         */
+        void releaseSession();
+
     public Q_SLOTS:
         /**
         * Sets up the environment and starts the authentication
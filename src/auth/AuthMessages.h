@@ -97,6 +97,8 @@ namespace SDDM {
         REQUEST,
         AUTHENTICATED,
         SESSION_STATUS,
+        START,
+        TRACE,
         MSG_LAST,
     };
 
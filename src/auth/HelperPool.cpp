@@ -0,0 +1,238 @@
+/*
+ * Pool of pre-started authentication helpers
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#include "HelperPool.h"
+#include "Constants.h"
+#include "LocaleEnvironment.h"
+#include "LoggingCategories.h"
+#include "SafeDataChannel.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QProcess>
+#include <QtCore/QTimer>
+#include <QtNetwork/QLocalSocket>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// longest a claimed helper's login holds up its replacement, prepared
+// logins wait for the user to type the password
+#define CLAIM_SETTLE_TIMEOUT 10000
+
+namespace SDDM {
+    static QString s_helperPath = QStringLiteral(LIBEXEC_INSTALL_DIR "/sddm-helper");
+
+    HelperPool::HelperPool(QObject *parent)
+            : QObject(parent)
+            , m_idleTimer(new QTimer(this))
+            , m_settleTimer(new QTimer(this)) {
+        connect(m_idleTimer, SIGNAL(timeout()), this, SLOT(retireIdle()));
+
+        m_settleTimer->setSingleShot(true);
+        m_settleTimer->setInterval(CLAIM_SETTLE_TIMEOUT);
+        connect(m_settleTimer, SIGNAL(timeout()), this, SLOT(replenish()));
+    }
+
+    HelperPool::~HelperPool() {
+        // closing their socket is enough for idle helpers to quit
+        for (const IdleHelper &helper : m_idle) {
+            helper.process->disconnect(this);
+            helper.channel->device()->close();
+            helper.process->terminate();
+        }
+        m_idle.clear();
+    }
+
+    int HelperPool::size() const {
+        return m_size;
+    }
+
+    void HelperPool::setSize(int size) {
+        m_size = qMax(0, size);
+
+        // get rid of the extra ones right away
+        while (m_idle.size() > m_size)
+            release(m_idle.takeLast());
+
+        QTimer::singleShot(0, this, SLOT(replenish()));
+    }
+
+    int HelperPool::idle() const {
+        return m_idle.size();
+    }
+
+    void HelperPool::setIdleTimeout(int seconds) {
+        // set again whenever the configuration is reloaded, don't put off
+        // retiring the idle helpers each time
+        if (qMax(0, seconds) == m_idleTimeout)
+            return;
+
+        m_idleTimeout = qMax(0, seconds);
+
+        if (m_idleTimeout > 0)
+            m_idleTimer->start(m_idleTimeout * 1000);
+        else
+            m_idleTimer->stop();
+    }
+
+    bool HelperPool::claim(QProcess **process, SafeDataChannel **channel) {
+        // drop whatever died while waiting
+        while (!m_idle.isEmpty() && m_idle.first().process->state() == QProcess::NotRunning)
+            release(m_idle.takeFirst());
+
+        if (m_idle.isEmpty())
+            return false;
+
+        IdleHelper helper = m_idle.takeFirst();
+        helper.process->disconnect(this);
+        helper.process->setParent(nullptr);
+        helper.channel->device()->setParent(nullptr);
+
+        *process = helper.process;
+        *channel = helper.channel;
+
+        qCDebug(SDDM_AUTH) << "Helper pool: Claimed a helper idle for" << helper.age.elapsed() << "ms";
+
+        // refill once the login is through, starting a helper now would
+        // compete with the very login it's meant to speed up
+        m_settleTimer->start();
+
+        return true;
+    }
+
+    void HelperPool::loginSettled() {
+        if (!m_settleTimer->isActive())
+            return;
+
+        m_settleTimer->stop();
+        QTimer::singleShot(0, this, SLOT(replenish()));
+    }
+
+    void HelperPool::replenish() {
+        // loginSettled() or the timeout get back here
+        if (m_settleTimer->isActive())
+            return;
+
+        while (m_idle.size() < m_size) {
+            QProcess *process = new QProcess(this);
+            process->setProcessEnvironment(processEnvironment());
+            process->setProcessChannelMode(processChannelMode());
+            connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(helperFinished()));
+            connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(helperFinished()));
+
+            SafeDataChannel *channel = startHelper(process, { QStringLiteral("--standby") }, this);
+            if (!channel) {
+                delete process;
+                return;
+            }
+
+            IdleHelper helper { process, channel, QElapsedTimer() };
+            helper.age.start();
+            m_idle << helper;
+        }
+    }
+
+    void HelperPool::helperFinished() {
+        QProcess *process = qobject_cast<QProcess *>(sender());
+
+        // not replacing it here, a helper which can't start would just loop
+        for (int i = 0; i < m_idle.size(); ++i) {
+            if (m_idle[i].process == process) {
+                qCWarning(SDDM_AUTH) << "Helper pool: Idle helper quit unexpectedly";
+                release(m_idle.takeAt(i));
+                return;
+            }
+        }
+    }
+
+    void HelperPool::retireIdle() {
+        const qint64 timeout = qint64(m_idleTimeout) * 1000;
+
+        for (int i = m_idle.size() - 1; i >= 0; --i) {
+            if (m_idle[i].age.elapsed() >= timeout)
+                release(m_idle.takeAt(i));
+        }
+
+        replenish();
+    }
+
+    void HelperPool::release(const IdleHelper &helper) {
+        helper.process->disconnect(this);
+
+        // the helper exits once it sees the end of its socket
+        connect(helper.process, SIGNAL(finished(int,QProcess::ExitStatus)), helper.process, SLOT(deleteLater()));
+        helper.channel->device()->close();
+        helper.channel->device()->deleteLater();
+
+        if (helper.process->state() == QProcess::NotRunning)
+            helper.process->deleteLater();
+    }
+
+    SafeDataChannel *HelperPool::startHelper(QProcess *process, QStringList args, QObject *parent) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            qCWarning(SDDM_AUTH, "Auth: socketpair() failed: %s", strerror(errno));
+            return nullptr;
+        }
+
+        // only the helper's end is inherited
+        QLocalSocket *socket = new QLocalSocket(parent);
+        if (::fcntl(fds[1], F_SETFD, 0) != 0 || !socket->setSocketDescriptor(fds[0])) {
+            qCWarning(SDDM_AUTH) << "Auth: Failed to set up the helper socket pair";
+            delete socket;
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return nullptr;
+        }
+
+        SafeDataChannel *channel = new SafeDataChannel(socket, socket);
+
+        args << QStringLiteral("--socket-fd") << QString::number(fds[1]);
+        process->start(s_helperPath, args);
+
+        // the helper has its own copy by now
+        ::close(fds[1]);
+
+        return channel;
+    }
+
+    QString HelperPool::helperPath() {
+        return s_helperPath;
+    }
+
+    void HelperPool::setHelperPath(const QString &path) {
+        s_helperPath = path;
+    }
+
+    QProcessEnvironment HelperPool::processEnvironment() {
+        QProcessEnvironment env = LocaleEnvironment::get();
+        if (!env.contains(QStringLiteral("LANG")))
+            env.insert(QStringLiteral("LANG"), QStringLiteral("C"));
+        return env;
+    }
+
+    QProcess::ProcessChannelMode HelperPool::processChannelMode() {
+        // the same as a verbose Auth
+        return QProcess::ForwardedChannels;
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Pool of pre-started authentication helpers
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#ifndef SDDM_HELPERPOOL_H
+#define SDDM_HELPERPOOL_H
+
+#include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QProcess>
+#include <QtCore/QProcessEnvironment>
+
+class QTimer;
+
+namespace SDDM {
+    class SafeDataChannel;
+
+    /**
+    * \brief
+    * Keeps a few sddm-helper processes started and waiting for a job
+    *
+    * \section description
+    * An idle helper has already been exec'd, linked and has its
+    * QCoreApplication and configuration set up. It sits on its end of a
+    * socket pair until \ref Auth sends it the job descriptor (user, session,
+    * flags), so claiming one skips all of that on the login path.
+    *
+    * Claimed helpers are replaced in the background, once the login they were
+    * claimed for got its result, see \ref loginSettled. Helpers which have been
+    * idle for longer than the idle timeout are retired and replaced as well,
+    * so that they pick up configuration changes.
+    */
+    class HelperPool : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(HelperPool)
+    public:
+        explicit HelperPool(QObject *parent = nullptr);
+        ~HelperPool();
+
+        /**
+        * Number of idle helpers to keep around, 0 disables the pool
+        */
+        int size() const;
+        void setSize(int size);
+
+        /**
+        * Number of helpers started and waiting to be claimed
+        */
+        int idle() const;
+
+        /**
+        * Idle helpers older than this are replaced, 0 keeps them forever
+        * @param seconds timeout in seconds
+        */
+        void setIdleTimeout(int seconds);
+
+        /**
+        * Takes an idle helper out of the pool
+        * @param process set to the helper process, now owned by the caller
+        * @param channel set to the daemon end of the helper's socket
+        * @return false if there's no idle helper
+        */
+        bool claim(QProcess **process, SafeDataChannel **channel);
+
+        /**
+        * Starts sddm-helper connected to us through a socket pair
+        * @param process process to start
+        * @param args helper arguments
+        * @param parent parent of the returned channel's socket
+        * @return channel to the helper, or nullptr if the socket pair couldn't
+        *         be set up, in which case the process isn't started
+        */
+        static SafeDataChannel *startHelper(QProcess *process, QStringList args, QObject *parent);
+
+        /**
+        * Path of the sddm-helper binary, the installed one unless overridden
+        * with \ref setHelperPath (the tests run a helper from the build tree)
+        */
+        static QString helperPath();
+        static void setHelperPath(const QString &path);
+
+        /**
+        * Environment every helper process is started with
+        */
+        static QProcessEnvironment processEnvironment();
+
+        /**
+        * Where the output of pooled helpers goes, only an \ref Auth whose
+        * own helper would be started the same way claims one
+        */
+        static QProcess::ProcessChannelMode processChannelMode();
+
+    public slots:
+        void replenish();
+
+        /**
+        * The login of the last claimed helper got its result, its
+        * replacement is started now rather than after a timeout
+        */
+        void loginSettled();
+
+    private slots:
+        void helperFinished();
+        void retireIdle();
+
+    private:
+        struct IdleHelper {
+            QProcess *process;
+            SafeDataChannel *channel;
+            QElapsedTimer age;
+        };
+
+        void release(const IdleHelper &helper);
+
+        QList<IdleHelper> m_idle;
+        QTimer *m_idleTimer { nullptr };
+        QTimer *m_settleTimer { nullptr };
+        int m_size { 0 };
+        int m_idleTimeout { 0 };
+    };
+}
+
+#endif // SDDM_HELPERPOOL_H
@@ -0,0 +1,179 @@
+/*
+ * System locale settings for helper processes
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#include "LocaleEnvironment.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+
+#include <sys/stat.h>
+
+#define LOCALE_CONF "/etc/locale.conf"
+
+namespace SDDM {
+    static bool isLocaleVariable(const QString &name) {
+        return name == QLatin1String("LANG") || name == QLatin1String("LANGUAGE") ||
+               name.startsWith(QLatin1String("LC_"));
+    }
+
+    static bool isValidName(const QByteArray &name) {
+        if (name.isEmpty() || (name[0] >= '0' && name[0] <= '9'))
+            return false;
+        for (char c : name) {
+            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_'))
+                return false;
+        }
+        return true;
+    }
+
+    QProcessEnvironment LocaleEnvironment::get() {
+        static QProcessEnvironment cached;
+        static bool loaded = false;
+        static struct stat cachedStat;
+
+        struct stat st;
+        if (::stat(LOCALE_CONF, &st) != 0) {
+            // no file, no locale settings
+            cached = QProcessEnvironment();
+            loaded = false;
+            return cached;
+        }
+
+        if (loaded && st.st_ino == cachedStat.st_ino && st.st_size == cachedStat.st_size &&
+            st.st_mtim.tv_sec == cachedStat.st_mtim.tv_sec && st.st_mtim.tv_nsec == cachedStat.st_mtim.tv_nsec)
+            return cached;
+
+        QFile file(QStringLiteral(LOCALE_CONF));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(SDDM_AUTH) << "Failed to read" << LOCALE_CONF << ":" << file.errorString();
+            return cached;
+        }
+
+        cached = parse(file.readAll());
+        cachedStat = st;
+        loaded = true;
+
+        return cached;
+    }
+
+    QProcessEnvironment LocaleEnvironment::parse(const QByteArray &contents) {
+        QProcessEnvironment env;
+
+        enum { Start, Comment, Name, Value, SingleQuoted, DoubleQuoted } state = Start;
+        QByteArray name, value, spaces;
+        bool quoted = false;
+
+        // one past the end stands in for a final newline
+        for (int i = 0; i <= contents.size(); ++i) {
+            const char c = i < contents.size() ? contents[i] : '\n';
+            const char next = i + 1 < contents.size() ? contents[i + 1] : '\n';
+
+            switch (state) {
+                case Start:
+                    if (c == '#' || c == ';')
+                        state = Comment;
+                    else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                        name = QByteArray(1, c);
+                        state = Name;
+                    }
+                    break;
+                case Comment:
+                    if (c == '\n')
+                        state = Start;
+                    break;
+                case Name:
+                    if (c == '=') {
+                        name = name.trimmed();
+                        if (name.startsWith("export ") || name.startsWith("export\t"))
+                            name = name.mid(7).trimmed();
+                        value.clear();
+                        spaces.clear();
+                        quoted = false;
+                        state = Value;
+                    } else if (c == '\n') {
+                        // not an assignment
+                        state = Start;
+                    } else {
+                        name += c;
+                    }
+                    break;
+                case Value:
+                    if (c == '\n') {
+                        if (isValidName(name) && isLocaleVariable(QString::fromLatin1(name)))
+                            env.insert(QString::fromLatin1(name), QString::fromUtf8(value));
+                        state = Start;
+                    } else if (c == ' ' || c == '\t' || c == '\r') {
+                        // only kept if more of the value follows
+                        if (!value.isEmpty() || quoted)
+                            spaces += c;
+                    } else if (c == '#' && (contents[i - 1] == ' ' || contents[i - 1] == '\t')) {
+                        // a word starting with # makes the rest of the line a comment
+                        while (i + 1 < contents.size() && contents[i + 1] != '\n')
+                            ++i;
+                    } else {
+                        value += spaces;
+                        spaces.clear();
+                        if (c == '\'') {
+                            quoted = true;
+                            state = SingleQuoted;
+                        } else if (c == '"') {
+                            quoted = true;
+                            state = DoubleQuoted;
+                        } else if (c == '\\' && i + 1 >= contents.size()) {
+                            // nothing left to escape, sh keeps it as it is
+                            value += c;
+                        } else if (c == '\\') {
+                            // escaped character or line continuation
+                            if (next != '\n')
+                                value += next;
+                            ++i;
+                        } else {
+                            value += c;
+                        }
+                    }
+                    break;
+                case SingleQuoted:
+                    if (c == '\'')
+                        state = Value;
+                    else if (i < contents.size())
+                        value += c;
+                    break;
+                case DoubleQuoted:
+                    if (c == '"') {
+                        state = Value;
+                    } else if (c == '\\' && i + 1 < contents.size() &&
+                               (next == '"' || next == '\\' || next == '$' || next == '`' || next == '\n')) {
+                        if (next != '\n')
+                            value += next;
+                        ++i;
+                    } else if (i < contents.size()) {
+                        value += c;
+                    }
+                    break;
+            }
+        }
+
+        if (state == SingleQuoted || state == DoubleQuoted)
+            qCWarning(SDDM_AUTH) << "Unterminated quote in" << LOCALE_CONF << ", ignoring the last assignment";
+
+        return env;
+    }
+}
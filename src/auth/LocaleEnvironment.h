@@ -0,0 +1,57 @@
+/*
+ * System locale settings for helper processes
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#ifndef SDDM_LOCALEENVIRONMENT_H
+#define SDDM_LOCALEENVIRONMENT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QProcessEnvironment>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Process-wide cache of the locale settings from /etc/locale.conf
+    *
+    * \section description
+    * The file is parsed the first time it's needed and only again after
+    * it changed on disk, which is checked with a single stat() per call.
+    *
+    * locale.conf is a shell-like assignment list: comments, blank lines,
+    * single and double quotes, backslash escapes and line continuations
+    * are handled the way the shell would. Only locale variables (LANG,
+    * LANGUAGE and LC_*) are taken from it.
+    */
+    class LocaleEnvironment {
+    public:
+        /**
+        * Locale variables from /etc/locale.conf, reloaded if the file changed
+        */
+        static QProcessEnvironment get();
+
+        /**
+        * Parses the contents of a locale.conf file
+        * @param contents raw file contents
+        * @return locale variables assigned in it
+        */
+        static QProcessEnvironment parse(const QByteArray &contents);
+    };
+}
+
+#endif // SDDM_LOCALEENVIRONMENT_H
@@ -39,10 +39,29 @@ namespace SDDM {
         //  Name                   Type         Default value                                   Description
         Entry(HaltCommand,         QString,     _S(HALT_COMMAND),                               _S("Halt command"));
         Entry(RebootCommand,       QString,     _S(REBOOT_COMMAND),                             _S("Reboot command"));
+        Entry(ShutdownTimeout,     int,         60,                                             _S("Seconds after which powering off or rebooting is reported as failed"));
+        Entry(SleepTimeout,        int,         30,                                             _S("Seconds after which suspending or hibernating is reported as failed"));
         Entry(Numlock,             NumState,    NUM_NONE,                                       _S("Initial NumLock state. Can be on, off or none.\n"
                                                                                                    "If property is set to none, numlock won't be changed\n"
                                                                                                    "NOTE: Currently ignored if autologin is enabled."));
         Entry(InputMethod,         QString,     QString(),                                      _S("Input method module"));
+        Entry(HelperPoolSize,      int,         0,                                              _S("Number of idle authentication helpers to keep started per seat.\n"
+                                                                                                   "Set to 0 to start a helper only when it's needed"));
+        Entry(HelperIdleTimeout,   int,         600,                                            _S("Seconds after which an idle authentication helper is replaced,\n"
+                                                                                                   "0 keeps it until it's used"));
+        Entry(StandbyDisplays,     int,         0,                                              _S("Number of greeter displays to keep started in the background per seat,\n"
+                                                                                                   "ready to be shown when switching users or logging out"));
+        Entry(StandbyMemoryLimit,  int,         0,                                              _S("Memory in MiB the standby display servers of a seat may use together,\n"
+                                                                                                   "0 for no limit"));
+        Entry(Seats,               QStringList, QStringList() << _S("seat0"),                   _S("Comma-separated list of seats to start a display on when logind isn't running\n"
+                                                                                                   "or fails to list the seats.\n"
+                                                                                                   "With logind, every seat which can show graphics gets a display"));
+        Entry(PrefetchSession,     bool,        false,                                          _S("Read the files used by the user's last session into the page cache\n"
+                                                                                                   "while the user is logging in"));
+        Entry(SessionLogMaxSize,   int,         10240,                                          _S("Size in KiB after which the user session log is rotated, 0 for no limit"));
+        Entry(SessionLogKeep,      int,         2,                                              _S("Number of rotated user session logs to keep, the previous session's among them"));
+        Entry(LoggingRules,        QStringList, QStringList(),                                  _S("Comma-separated list of logging rules, e.g. sddm.*.debug=false,sddm.auth.debug=true\n"
+                                                                                                   "The categories are listed in sddm.conf(5)"));
         //  Name   Entries (but it's a regular class again)
         Section(Theme,
             Entry(ThemeDir,            QString,     _S(DATA_INSTALL_DIR "/themes"),             _S("Theme directory path"));
@@ -60,13 +79,17 @@ namespace SDDM {
         Section(X11,
             Entry(ServerPath,          QString,     _S("/usr/bin/X"),                           _S("Path to X server binary"));
             Entry(ServerArguments,     QString,     _S("-nolisten tcp"),                        _S("Arguments passed to the X server invocation"));
+            Entry(ServerTimeout,       int,         30,                                         _S("Seconds to wait for the X server to report its display"));
+            Entry(ReuseServer,         bool,        false,                                      _S("Reset the X server and start the greeter on it again when a session ends,\n"
+                                                                                                   "instead of starting a new one"));
             Entry(XephyrPath,          QString,     _S("/usr/bin/Xephyr"),                      _S("Path to Xephyr binary"));
-            Entry(XauthPath,           QString,     _S("/usr/bin/xauth"),                       _S("Path to xauth binary"));
+            Entry(XauthPath,           QString,     _S("/usr/bin/xauth"),                       _S("Path to xauth binary, unused since the cookies are written directly"));
             Entry(SessionDir,          QString,     _S("/usr/share/xsessions"),                 _S("Directory containing available X sessions"));
             Entry(SessionCommand,      QString,     _S(SESSION_COMMAND),                        _S("Path to a script to execute when starting the desktop session"));
 	    Entry(SessionLogFile,      QString,     _S(".local/share/sddm/xorg-session.log"),   _S("Path to the user session log file"));
 	    Entry(UserAuthFile,        QString,     _S(".Xauthority"),                          _S("Path to the Xauthority file"));
             Entry(DisplayCommand,      QString,     _S(DATA_INSTALL_DIR "/scripts/Xsetup"),     _S("Path to a script to execute when starting the display server"));
+            Entry(WaitForDisplayCommand,bool,       true,                                       _S("Wait for the display setup script to finish before starting the greeter"));
             Entry(DisplayStopCommand,  QString,     _S(DATA_INSTALL_DIR "/scripts/Xstop"),      _S("Path to a script to execute when stopping the display server"));
             Entry(MinimumVT,           int,         MINIMUM_VT,                                 _S("The lowest virtual terminal number that will be used."));
             Entry(EnableHiDPI,         bool,        false,                                      _S("Enable Qt's automatic high-DPI scaling"));
@@ -95,6 +118,15 @@ namespace SDDM {
             Entry(Session,             QString,     QString(),                                  _S("Name of session file for autologin session (if empty try last logged in)"));
             Entry(Relogin,             bool,        false,                                      _S("Whether sddm should automatically log back into sessions when they exit"));
         );
+
+        Section(PamPrompts,
+            Entry(Password,            QString,     QString(),                                  _S("Regular expression matching the word \"password\" in PAM prompts,\n"
+                                                                                                   "in addition to the built-in ones"));
+            Entry(CurrentPassword,     QString,     QString(),                                  _S("Regular expression matching prompts for the current password"));
+            Entry(NewPassword,         QString,     QString(),                                  _S("Regular expression matching prompts for a new password"));
+            Entry(RepeatPassword,      QString,     QString(),                                  _S("Regular expression matching prompts to repeat the new password"));
+            Entry(PasswordChange,      QString,     QString(),                                  _S("Regular expression matching PAM messages announcing a password change"));
+        );
     );
 
     Config(StateConfig, []()->QString{auto tmp = getpwnam("sddm"); return tmp ? QString::fromLocal8Bit(tmp->pw_dir) : QStringLiteral(STATE_DIR);}().append(QStringLiteral("/state.conf")),
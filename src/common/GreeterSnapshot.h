@@ -0,0 +1,62 @@
+/*
+ * Everything the greeter needs to show up, sent by the daemon on Connect
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_GREETERSNAPSHOT_H
+#define SDDM_GREETERSNAPSHOT_H
+
+#include <QDataStream>
+#include <QString>
+#include <QVariantMap>
+
+namespace SDDM {
+    /**
+    * The initial state of the greeter, as the daemon knows it
+    *
+    * The theme is described as the daemon resolved it: \a themePath is
+    * empty for the embedded theme, \a themeConfig has the theme's config
+    * file with the user's overrides already applied.
+    */
+    struct GreeterSnapshot {
+        QString hostName;
+        quint32 capabilities { 0 };
+        QString themePath;
+        QString mainScript;
+        QString translationsDirectory;
+        QVariantMap themeConfig;
+        QString lastUser;
+        QString lastSession;
+    };
+
+    inline QDataStream &operator<<(QDataStream &stream, const GreeterSnapshot &snapshot) {
+        stream << snapshot.hostName << snapshot.capabilities
+               << snapshot.themePath << snapshot.mainScript << snapshot.translationsDirectory
+               << snapshot.themeConfig << snapshot.lastUser << snapshot.lastSession;
+        return stream;
+    }
+
+    inline QDataStream &operator>>(QDataStream &stream, GreeterSnapshot &snapshot) {
+        stream >> snapshot.hostName >> snapshot.capabilities
+               >> snapshot.themePath >> snapshot.mainScript >> snapshot.translationsDirectory
+               >> snapshot.themeConfig >> snapshot.lastUser >> snapshot.lastSession;
+        return stream;
+    }
+}
+
+#endif // SDDM_GREETERSNAPSHOT_H
@@ -0,0 +1,236 @@
+/*
+ * Asynchronous writer of the log file
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LogWriter.h"
+
+#include "Constants.h"
+#include "LoginTrace.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace SDDM {
+    // set once the writer stopped at exit
+    static QAtomicInt s_direct { 0 };
+
+    LogWriter *LogWriter::instance() {
+        static LogWriter *writer = [] {
+            LogWriter *writer = new LogWriter();
+            atexit(stop);
+            writer->start(QThread::LowPriority);
+            return writer;
+        }();
+        return writer;
+    }
+
+    LogWriter::LogWriter() : QThread(), m_pid(getpid()) {
+        for (int i = 0; i < CAPACITY; ++i)
+            m_slots[i].sequence.store(i);
+
+        // try to open file, fall back to stdout
+        m_fd = open(LOG_FILE, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (m_fd != -1) {
+            QByteArray line;
+            appendLine(line, LoginTrace::now(), QtInfoMsg, "",
+                       "Log opened on " + QDateTime::currentDateTime().toString(Qt::ISODate).toLatin1() +
+                       ", timestamps are seconds since boot");
+            writeOut(line);
+        }
+    }
+
+    void LogWriter::write(QtMsgType type, const char *prefix, const QString &message) {
+        QByteArray text = message.toLocal8Bit();
+
+        // nothing waits for the queue anymore, a forked child doesn't have
+        // the writer thread, or it's about to abort
+        if (s_direct.load() || getpid() != m_pid || type == QtFatalMsg) {
+            if (type == QtFatalMsg)
+                flush();
+            QByteArray line;
+            appendLine(line, LoginTrace::now(), type, prefix, text);
+            writeOut(line);
+            return;
+        }
+
+        if (!push(type, prefix, text))
+            return;
+
+        // only bother the writer when it sleeps
+        if (m_sleeping.load())
+            m_wakeup.wakeOne();
+    }
+
+    void LogWriter::flush() {
+        if (s_direct.load() || getpid() != m_pid || !isRunning())
+            return;
+
+        const quint64 queued = m_head.loadAcquire();
+        QElapsedTimer timer;
+        timer.start();
+        while (m_written.loadAcquire() < queued && !timer.hasExpired(1000)) {
+            m_wakeup.wakeOne();
+            QThread::msleep(1);
+        }
+    }
+
+    void LogWriter::run() {
+        QByteArray batch;
+        batch.reserve(64 * 1024);
+
+        forever {
+            const int count = takeBatch(batch);
+
+            const quint64 dropped = m_dropped.fetchAndStoreRelaxed(0);
+            if (dropped)
+                appendLine(batch, LoginTrace::now(), QtWarningMsg, "",
+                           "Log buffer full, " + QByteArray::number(dropped) + " messages dropped");
+
+            if (!batch.isEmpty()) {
+                writeOut(batch);
+                batch.clear();
+                m_written.fetchAndAddRelease(count);
+                continue;
+            }
+
+            if (m_quit.loadAcquire())
+                break;
+
+            // wake up now and then, in case a message slipped in
+            // between the last look and falling asleep
+            QMutexLocker locker(&m_mutex);
+            m_sleeping.store(1);
+            m_wakeup.wait(&m_mutex, 50);
+            m_sleeping.store(0);
+        }
+    }
+
+    void LogWriter::stop() {
+        LogWriter *writer = instance();
+
+        // a forked child exiting, the thread isn't there to wait for
+        if (getpid() != writer->m_pid)
+            return;
+
+        // whatever is logged from now on is written right away
+        writer->m_quit.storeRelease(1);
+        writer->m_wakeup.wakeOne();
+        writer->wait();
+        s_direct.store(1);
+
+        // and what slipped in while it was stopping
+        QByteArray batch;
+        while (writer->takeBatch(batch)) {
+            writer->writeOut(batch);
+            batch.clear();
+        }
+    }
+
+    bool LogWriter::push(QtMsgType type, const char *prefix, QByteArray &message) {
+        // bounded multi-producer queue: each slot carries the position it
+        // can be written at, and the one after once it's been written
+        quint64 position = m_head.load();
+        Slot *slot;
+        forever {
+            slot = &m_slots[position % CAPACITY];
+            const qint64 diff = qint64(slot->sequence.loadAcquire()) - qint64(position);
+            if (diff == 0) {
+                if (m_head.testAndSetRelaxed(position, position + 1, position))
+                    break;
+            } else if (diff < 0) {
+                m_dropped.fetchAndAddRelaxed(1);
+                return false;
+            } else {
+                position = m_head.load();
+            }
+        }
+
+        slot->time = LoginTrace::now();
+        slot->type = type;
+        slot->prefix = prefix;
+        slot->message.swap(message);
+        slot->sequence.storeRelease(position + 1);
+
+        return true;
+    }
+
+    int LogWriter::takeBatch(QByteArray &batch) {
+        int count = 0;
+
+        while (count < BATCH) {
+            Slot &slot = m_slots[m_tail % CAPACITY];
+            if (slot.sequence.loadAcquire() != m_tail + 1)
+                break;
+
+            appendLine(batch, slot.time, slot.type, slot.prefix, slot.message);
+            slot.message.clear();
+            slot.sequence.storeRelease(m_tail + CAPACITY);
+            ++m_tail;
+            ++count;
+        }
+
+        return count;
+    }
+
+    void LogWriter::writeOut(const QByteArray &data) {
+        const int fd = m_fd != -1 ? m_fd : STDOUT_FILENO;
+
+        const char *p = data.constData();
+        qint64 left = data.size();
+        while (left > 0) {
+            const ssize_t written = ::write(fd, p, left);
+            if (written == -1) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            p += written;
+            left -= written;
+        }
+    }
+
+    void LogWriter::appendLine(QByteArray &out, qint64 time, QtMsgType type,
+                               const char *prefix, const QByteArray &message) {
+        // set log priority
+        const char *priority = "(II)";
+        switch (type) {
+            case QtWarningMsg:
+                priority = "(WW)";
+            break;
+            case QtCriticalMsg:
+            case QtFatalMsg:
+                priority = "(EE)";
+            break;
+            default:
+            break;
+        }
+
+        char stamp[48];
+        snprintf(stamp, sizeof(stamp), "[%6lld.%03lld] %s ",
+                 static_cast<long long>(time / 1000000), static_cast<long long>(time / 1000 % 1000), priority);
+
+        out.append(stamp).append(prefix).append(message).append('\n');
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * Asynchronous writer of the log file
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_LOGWRITER_H
+#define SDDM_LOGWRITER_H
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Writes log messages to the log file from a thread of its own
+    *
+    * \section description
+    * Messages are queued in a fixed size ring buffer, without taking any
+    * lock, and written in batches by the writer thread. When the buffer is
+    * full messages are dropped, how many is written to the log as soon as
+    * there's room again.
+    *
+    * Lines are stamped with the monotonic time, in seconds, as a wall clock
+    * timestamp costs more and the journal shows both anyway. Every process
+    * notes the wall clock time once when it opens the log.
+    *
+    * Fatal messages, messages of forked children, which don't have the
+    * thread, and messages logged once the writer stopped at exit are
+    * written right away.
+    */
+    class LogWriter : public QThread {
+        Q_OBJECT
+        Q_DISABLE_COPY(LogWriter)
+    public:
+        static LogWriter *instance();
+
+        /**
+        * Queues a message
+        * @param prefix name of the program, must outlive the writer
+        */
+        void write(QtMsgType type, const char *prefix, const QString &message);
+
+        /**
+        * Waits for what's been queued so far to be written
+        */
+        void flush();
+
+    protected:
+        void run() override;
+
+    private:
+        LogWriter();
+
+        static void stop();
+
+        struct Slot {
+            QAtomicInteger<quint64> sequence;
+            qint64 time { 0 };
+            QtMsgType type { QtDebugMsg };
+            const char *prefix { nullptr };
+            QByteArray message;
+        };
+
+        bool push(QtMsgType type, const char *prefix, QByteArray &message);
+        int takeBatch(QByteArray &batch);
+        void writeOut(const QByteArray &data);
+        static void appendLine(QByteArray &out, qint64 time, QtMsgType type,
+                               const char *prefix, const QByteArray &message);
+
+        static const int CAPACITY = 4096;
+        static const int BATCH = 256;
+
+        Slot m_slots[CAPACITY];
+        QAtomicInteger<quint64> m_head { 0 };
+        quint64 m_tail { 0 };
+        QAtomicInteger<quint64> m_written { 0 };
+        QAtomicInteger<quint64> m_dropped { 0 };
+
+        QMutex m_mutex;
+        QWaitCondition m_wakeup;
+        QAtomicInt m_sleeping { 0 };
+        QAtomicInt m_quit { 0 };
+
+        int m_fd { -1 };
+        qint64 m_pid { 0 };
+    };
+}
+
+#endif // SDDM_LOGWRITER_H
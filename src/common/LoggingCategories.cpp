@@ -0,0 +1,45 @@
+/*
+ * Logging categories of the daemon, the helper and the greeter
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LoggingCategories.h"
+
+Q_LOGGING_CATEGORY(SDDM_DAEMON, "sddm.daemon")
+Q_LOGGING_CATEGORY(SDDM_DISPLAY, "sddm.daemon.display")
+Q_LOGGING_CATEGORY(SDDM_SEAT, "sddm.daemon.seat")
+Q_LOGGING_CATEGORY(SDDM_VT, "sddm.daemon.vt")
+Q_LOGGING_CATEGORY(SDDM_SOCKET, "sddm.daemon.socket")
+Q_LOGGING_CATEGORY(SDDM_POWER, "sddm.daemon.power")
+
+Q_LOGGING_CATEGORY(SDDM_AUTH, "sddm.auth")
+Q_LOGGING_CATEGORY(SDDM_IPC, "sddm.auth.ipc")
+Q_LOGGING_CATEGORY(SDDM_HELPER, "sddm.helper")
+Q_LOGGING_CATEGORY(SDDM_PAM, "sddm.helper.pam")
+
+Q_LOGGING_CATEGORY(SDDM_GREETER, "sddm.greeter")
+Q_LOGGING_CATEGORY(SDDM_PROXY, "sddm.greeter.proxy")
+Q_LOGGING_CATEGORY(SDDM_MODELS, "sddm.greeter.models")
+
+Q_LOGGING_CATEGORY(SDDM_SESSION, "sddm.session")
+
+namespace SDDM {
+    void setLoggingRules(const QStringList &rules) {
+        QLoggingCategory::setFilterRules(rules.join(QLatin1Char('\n')));
+    }
+}
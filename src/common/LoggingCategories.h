@@ -0,0 +1,58 @@
+/*
+ * Logging categories of the daemon, the helper and the greeter
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_LOGGINGCATEGORIES_H
+#define SDDM_LOGGINGCATEGORIES_H
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QStringList>
+
+// daemon
+Q_DECLARE_LOGGING_CATEGORY(SDDM_DAEMON)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_DISPLAY)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_SEAT)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_VT)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_SOCKET)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_POWER)
+
+// authentication, on the daemon side and in the helper
+Q_DECLARE_LOGGING_CATEGORY(SDDM_AUTH)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_IPC)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_HELPER)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_PAM)
+
+// greeter
+Q_DECLARE_LOGGING_CATEGORY(SDDM_GREETER)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_PROXY)
+Q_DECLARE_LOGGING_CATEGORY(SDDM_MODELS)
+
+// shared
+Q_DECLARE_LOGGING_CATEGORY(SDDM_SESSION)
+
+namespace SDDM {
+    /**
+    * Replaces the logging rules, in the QLoggingCategory::setFilterRules()
+    * format with one rule per entry, e.g. "sddm.auth.debug=false".
+    * QT_LOGGING_RULES still takes precedence.
+    */
+    void setLoggingRules(const QStringList &rules);
+}
+
+#endif // SDDM_LOGGINGCATEGORIES_H
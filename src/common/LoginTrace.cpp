@@ -0,0 +1,94 @@
+/*
+ * Per-login phase timestamps
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LoginTrace.h"
+
+#include <QtCore/QStringList>
+
+#include <algorithm>
+#include <time.h>
+
+namespace SDDM {
+    LoginTrace::LoginTrace(quint64 id) : m_id(id) {
+    }
+
+    quint64 LoginTrace::newId() {
+        static quint64 lastId = 0;
+        return ++lastId;
+    }
+
+    qint64 LoginTrace::now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    quint64 LoginTrace::id() const {
+        return m_id;
+    }
+
+    bool LoginTrace::isEmpty() const {
+        return m_marks.isEmpty();
+    }
+
+    const QString &LoginTrace::user() const {
+        return m_user;
+    }
+
+    void LoginTrace::setUser(const QString &user) {
+        m_user = user;
+    }
+
+    void LoginTrace::mark(const QString &phase, qint64 timestamp) {
+        if (m_id == 0 || timestamp <= 0)
+            return;
+        m_marks.append(qMakePair(phase, timestamp));
+    }
+
+    QVector<QPair<QString, qint64>> LoginTrace::marks() const {
+        // marks from other processes may arrive a bit out of order
+        QVector<QPair<QString, qint64>> marks = m_marks;
+        std::stable_sort(marks.begin(), marks.end(),
+                         [](const QPair<QString, qint64> &a, const QPair<QString, qint64> &b) {
+                             return a.second < b.second;
+                         });
+        return marks;
+    }
+
+    QString LoginTrace::toString() const {
+        if (m_marks.isEmpty())
+            return QStringLiteral("login %1: no phases recorded").arg(m_id);
+
+        const QVector<QPair<QString, qint64>> marks = this->marks();
+
+        QStringList phases;
+        qint64 previous = marks.first().second;
+        for (const auto &mark : marks) {
+            phases << QStringLiteral("%1 +%2").arg(mark.first).arg((mark.second - previous) / 1000.0, 0, 'f', 1);
+            previous = mark.second;
+        }
+
+        return QStringLiteral("login %1 (%2) took %3 ms: %4")
+                .arg(m_id)
+                .arg(m_user)
+                .arg((marks.last().second - marks.first().second) / 1000.0, 0, 'f', 1)
+                .arg(phases.join(QStringLiteral(", ")));
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Per-login phase timestamps
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_LOGINTRACE_H
+#define SDDM_LOGINTRACE_H
+
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Timestamps of the phases a single login goes through
+    *
+    * \section description
+    * Timestamps come from CLOCK_MONOTONIC, which is shared by every process
+    * on the machine, so the greeter and the helper can take their own and
+    * send them over to the daemon to be merged into the same trace.
+    *
+    * A trace with id 0 isn't recorded.
+    */
+    class LoginTrace {
+    public:
+        explicit LoginTrace(quint64 id = 0);
+
+        /**
+        * Allocates a new, daemon-wide unique login id
+        */
+        static quint64 newId();
+
+        /**
+        * Current monotonic time in microseconds
+        */
+        static qint64 now();
+
+        quint64 id() const;
+        bool isEmpty() const;
+
+        const QString &user() const;
+        void setUser(const QString &user);
+
+        /**
+        * Records that a phase was reached
+        * @param phase name of the phase
+        * @param timestamp when it was reached, as returned by \ref now
+        */
+        void mark(const QString &phase, qint64 timestamp = now());
+
+        /**
+        * Phases recorded so far, in chronological order
+        */
+        QVector<QPair<QString, qint64>> marks() const;
+
+        /**
+        * One line breakdown: total time, then each phase with the time
+        * elapsed since the previous one
+        */
+        QString toString() const;
+
+    private:
+        quint64 m_id { 0 };
+        QString m_user { };
+        QVector<QPair<QString, qint64>> m_marks { };
+    };
+}
+
+#endif // SDDM_LOGINTRACE_H
@@ -22,9 +22,7 @@
 #define SDDM_MESSAGEHANDLER_H
 
 #include "Constants.h"
-
-#include <QDateTime>
-#include <QFile>
+#include "LogWriter.h"
 
 #include <stdio.h>
 
@@ -66,84 +64,41 @@ namespace SDDM {
     }
 #endif
 
-    static void standardLogger(QtMsgType type, const QString &msg) {
-        static QFile file(QStringLiteral(LOG_FILE));
-
-        // try to open file only if it's not already open
-        if (!file.isOpen()) {
-            if (!file.open(QFile::Append | QFile::WriteOnly))
-                file.open(QFile::Truncate | QFile::WriteOnly);
-        }
-
-        // create timestamp
-        QString timestamp = QDateTime::currentDateTime().toString(QStringLiteral("hh:mm:ss.zzz"));
-
-        // set log priority
-	QString logPriority = QStringLiteral("(II)");
-        switch (type) {
-            case QtDebugMsg:
-            break;
-            case QtWarningMsg:
-                logPriority = QStringLiteral("(WW)");
-            break;
-            case QtCriticalMsg:
-            case QtFatalMsg:
-                logPriority = QStringLiteral("(EE)");
-            break;
-	    default:
-	    break;
-        }
-
-        // prepare log message
-        QString logMessage = QStringLiteral("[%1] %2 %3\n").arg(timestamp).arg(logPriority).arg(msg);
-
-        // log message
-        if (file.isOpen()) {
-            file.write(logMessage.toLocal8Bit());
-            file.flush();
-        } else {
-            printf("%s", qPrintable(logMessage));
-            fflush(stdout);
-        }
+    static void standardLogger(QtMsgType type, const char *prefix, const QString &msg) {
+        // queued and written to file or stdout by the writer thread
+        LogWriter::instance()->write(type, prefix, msg);
     }
 
-    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &prefix, const QString &msg) {
-        // copy message to edit it
-        QString logMessage = msg;
-
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const char *prefix, const QString &msg) {
 #ifdef HAVE_JOURNALD
         // don't log to journald if running interactively, this is likely
         // the case when running sddm in test mode
         static bool isInteractive = isatty(STDIN_FILENO);
         if (!isInteractive) {
             // log to journald
-            journaldLogger(type, context, logMessage);
+            journaldLogger(type, context, msg);
         } else {
-            // prepend program name
-            logMessage = prefix + msg;
-
-            // log to file or stdout
-            standardLogger(type, logMessage);
+            // log to file or stdout, with the program name prepended
+            standardLogger(type, prefix, msg);
         }
 #else
-        // prepend program name
-        logMessage = prefix + msg;
+        Q_UNUSED(context)
 
-        // log to file or stdout
-        standardLogger(type, logMessage);
+        // log to file or stdout, with the program name prepended
+        standardLogger(type, prefix, msg);
 #endif
     }
 
     void DaemonMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
-        messageHandler(type, context, QStringLiteral("DAEMON: "), msg);
+        messageHandler(type, context, "DAEMON: ", msg);
     }
 
     void HelperMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
-        messageHandler(type, context, QStringLiteral("HELPER: "), msg);
+        messageHandler(type, context, "HELPER: ", msg);
     }
 
     void GreeterMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
-        messageHandler(type, context, QStringLiteral("GREETER: "), msg);
+        messageHandler(type, context, "GREETER: ", msg);
     }
 }
 
@@ -30,14 +30,24 @@ namespace SDDM {
         Reboot,
         Suspend,
         Hibernate,
-        HybridSleep
+        HybridSleep,
+        PrepareLogin,
+        Trace
     };
 
     enum class DaemonMessages {
         HostName,
         Capabilities,
         LoginSucceeded,
-        LoginFailed
+        LoginFailed,
+        PowerActionFinished,
+        Handshake
+    };
+
+    enum class PowerActionResult {
+        Succeeded = 0,
+        Failed,
+        Inhibited
     };
 
     enum Capability {
@@ -0,0 +1,115 @@
+/*
+ * Asynchronous length-prefixed message channel
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SafeDataChannel.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QIODevice>
+#include <QtCore/QPointer>
+
+// nothing we exchange with the helper comes anywhere close to this
+#define MAX_MESSAGE_LENGTH (16 * 1024 * 1024)
+
+namespace SDDM {
+    SafeDataChannel::SafeDataChannel(QIODevice *device, QObject *parent)
+            : QObject(parent)
+            , m_device(device) {
+        connect(m_device, SIGNAL(readyRead()), this, SLOT(readPending()));
+    }
+
+    QIODevice *SafeDataChannel::device() const {
+        return m_device;
+    }
+
+    bool SafeDataChannel::send(const QByteArray &data) {
+        const qint64 length = data.length();
+
+        if (!m_device->isOpen()) {
+            qCCritical(SDDM_IPC) << " Auth: SafeDataChannel: Could not write any data";
+            return false;
+        }
+
+        // queue the prefix and the payload back to back, the event loop
+        // takes care of pushing them out
+        if (m_device->write(reinterpret_cast<const char *>(&length), sizeof(length)) != sizeof(length)
+            || m_device->write(data.constData(), length) != length) {
+            qCCritical(SDDM_IPC) << " Auth: SafeDataChannel: Could not queue all data";
+            return false;
+        }
+
+        return true;
+    }
+
+    void SafeDataChannel::readPending() {
+        // a receiver may delete us while handling a message
+        QPointer<SafeDataChannel> guard(this);
+
+        while (m_device->isOpen() && m_device->bytesAvailable() > 0) {
+            // length prefix, possibly split across several reads
+            if (m_headerOffset < qint64(sizeof(m_length))) {
+                qint64 read = m_device->read(reinterpret_cast<char *>(&m_length) + m_headerOffset,
+                                             sizeof(m_length) - m_headerOffset);
+                if (read <= 0)
+                    return;
+                m_headerOffset += read;
+                if (m_headerOffset < qint64(sizeof(m_length)))
+                    return;
+
+                if (m_length < 0 || m_length > MAX_MESSAGE_LENGTH) {
+                    qCCritical(SDDM_IPC) << " Auth: SafeDataChannel: Invalid message length" << m_length;
+                    resetFrame();
+                    m_device->close();
+                    return;
+                }
+
+                m_payload.resize(m_length);
+                m_offset = 0;
+            }
+
+            // payload, read straight into place
+            if (m_offset < m_length) {
+                qint64 read = m_device->read(m_payload.data() + m_offset, m_length - m_offset);
+                if (read < 0) {
+                    qCCritical(SDDM_IPC) << " Auth: SafeDataChannel: Could not read from the device";
+                    resetFrame();
+                    return;
+                }
+                m_offset += read;
+                if (m_offset < m_length)
+                    return;
+            }
+
+            QByteArray message = m_payload;
+            resetFrame();
+
+            emit messageReceived(message);
+            if (!guard)
+                return;
+        }
+    }
+
+    void SafeDataChannel::resetFrame() {
+        m_length = 0;
+        m_headerOffset = 0;
+        m_offset = 0;
+        m_payload = QByteArray();
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Asynchronous length-prefixed message channel
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SAFEDATACHANNEL_H
+#define SAFEDATACHANNEL_H
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+
+class QIODevice;
+
+namespace SDDM {
+    /**
+    * \brief
+    * Event driven counterpart of \ref SafeDataStream
+    *
+    * \section description
+    * Speaks the same wire format (a native qint64 length followed by the
+    * payload) but never waits on the device. Incoming bytes are collected
+    * into a preallocated buffer as they arrive and every complete frame
+    * is delivered through \ref messageReceived. Outgoing frames are queued
+    * into the device's write buffer and flushed by the event loop.
+    *
+    * A peer which stops talking halfway through a frame therefore only
+    * leaves a partial buffer behind instead of stalling the caller.
+    */
+    class SafeDataChannel : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(SafeDataChannel)
+    public:
+        explicit SafeDataChannel(QIODevice *device, QObject *parent = nullptr);
+
+        QIODevice *device() const;
+
+        /**
+        * Queues one frame for writing, doesn't wait for it to be written
+        * @param data payload of the frame
+        * @return true if the whole frame was accepted by the device
+        */
+        bool send(const QByteArray &data);
+
+    public slots:
+        /**
+        * Consumes whatever is available on the device right now
+        */
+        void readPending();
+
+    signals:
+        /**
+        * Emitted for every complete frame, in order of arrival
+        * @param message payload of the frame
+        */
+        void messageReceived(const QByteArray &message);
+
+    private:
+        void resetFrame();
+
+        QIODevice *m_device { nullptr };
+        qint64 m_length { 0 };
+        qint64 m_headerOffset { 0 };
+        qint64 m_offset { 0 };
+        QByteArray m_payload { };
+    };
+}
+
+#endif // SAFEDATACHANNEL_H
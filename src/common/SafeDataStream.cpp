@@ -19,6 +19,7 @@
  */
 
 #include "SafeDataStream.h"
+#include "LoggingCategories.h"
 
 #include <QtCore/QDebug>
 
@@ -31,18 +32,22 @@ namespace SDDM {
         qint64 length = m_data.length();
         qint64 writtenTotal = 0;
         if (!m_device->isOpen()) {
-            qCritical() << " Auth: SafeDataStream: Could not write any data";
+            qCCritical(SDDM_IPC) << " Auth: SafeDataStream: Could not write any data";
             return;
         }
         m_device->write((const char*) &length, sizeof(length));
         while (writtenTotal != length) {
-            qint64 written = m_device->write(m_data.mid(writtenTotal));
+            // write the remainder in place instead of copying it out
+            qint64 written = m_device->write(m_data.constData() + writtenTotal, length - writtenTotal);
             if (written < 0 || !m_device->isOpen()) {
-                qCritical() << " Auth: SafeDataStream: Could not write all stored data";
+                qCCritical(SDDM_IPC) << " Auth: SafeDataStream: Could not write all stored data";
                 return;
             }
             writtenTotal += written;
-            m_device->waitForBytesWritten(-1);
+        }
+        while (m_device->bytesToWrite() > 0) {
+            if (!m_device->waitForBytesWritten(-1))
+                break;
         }
 
         reset();
@@ -52,7 +57,7 @@ namespace SDDM {
         qint64 length = -1;
 
         if (!m_device->isOpen()) {
-            qCritical() << " Auth: SafeDataStream: Could not read from the device";
+            qCCritical(SDDM_IPC) << " Auth: SafeDataStream: Could not read from the device";
             return;
         }
         if (!m_device->bytesAvailable())
@@ -65,7 +70,7 @@ namespace SDDM {
 
         while (m_data.length() < length) {
             if (!m_device->isOpen()) {
-                qCritical() << " Auth: SafeDataStream: Could not read from the device";
+                qCCritical(SDDM_IPC) << " Auth: SafeDataStream: Could not read from the device";
                 return;
             }
             if (!m_device->bytesAvailable())
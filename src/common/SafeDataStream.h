@@ -24,6 +24,10 @@
 #include <QtCore/QDataStream>
 
 namespace SDDM {
+    /**
+    * Blocking framed stream, used by sddm-helper which runs its conversation
+    * synchronously. The daemon side uses \ref SafeDataChannel instead.
+    */
     class SafeDataStream : public QDataStream {
     public:
         SafeDataStream(QIODevice* device);
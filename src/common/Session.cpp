@@ -23,6 +23,7 @@
 #include <QTextStream>
 
 #include "Configuration.h"
+#include "LoggingCategories.h"
 #include "Session.h"
 
 const QString s_entryExtention = QStringLiteral(".desktop");
@@ -139,7 +140,7 @@ namespace SDDM {
 
         m_fileName = m_dir.absoluteFilePath(fileName);
 
-        qDebug() << "Reading from" << m_fileName;
+        qCDebug(SDDM_SESSION) << "Reading from" << m_fileName;
 
         QFile file(m_fileName);
         if (!file.open(QIODevice::ReadOnly))
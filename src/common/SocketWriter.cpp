@@ -38,6 +38,12 @@ namespace SDDM {
         return *this;
     }
 
+    SocketWriter &SocketWriter::operator << (const qint64 &i) {
+        *output << i;
+
+        return *this;
+    }
+
     SocketWriter &SocketWriter::operator << (const QString &s) {
         *output << s;
 
@@ -49,4 +55,10 @@ namespace SDDM {
 
         return *this;
     }
+
+    SocketWriter &SocketWriter::operator << (const GreeterSnapshot &s) {
+        *output << s;
+
+        return *this;
+    }
 }
@@ -24,6 +24,7 @@
 #include <QDataStream>
 #include <QLocalSocket>
 
+#include "GreeterSnapshot.h"
 #include "Session.h"
 
 namespace SDDM {
@@ -34,8 +35,10 @@ namespace SDDM {
         ~SocketWriter();
 
         SocketWriter &operator << (const quint32 &u);
+        SocketWriter &operator << (const qint64 &i);
         SocketWriter &operator << (const QString &s);
         SocketWriter &operator << (const Session &s);
+        SocketWriter &operator << (const GreeterSnapshot &s);
 
     private:
         QByteArray data;
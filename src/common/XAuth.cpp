@@ -0,0 +1,168 @@
+/*
+ * X authority file writer
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "XAuth.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <X11/Xauth.h>
+
+#define COOKIE_LENGTH 16
+
+namespace SDDM {
+    static const char cookieName[] = "MIT-MAGIC-COOKIE-1";
+
+    static bool readRandom(char *buffer, size_t length) {
+#ifdef SYS_getrandom
+        // doesn't need a file descriptor and blocks only until the pool
+        // has been initialized once
+        while (length > 0) {
+            long result = ::syscall(SYS_getrandom, buffer, length, 0);
+            if (result < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            buffer += result;
+            length -= size_t(result);
+        }
+        if (length == 0)
+            return true;
+#endif
+
+        // kernels older than 3.17
+        int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        while (length > 0) {
+            ssize_t result = ::read(fd, buffer, length);
+            if (result <= 0) {
+                if (result < 0 && errno == EINTR)
+                    continue;
+                break;
+            }
+            buffer += result;
+            length -= size_t(result);
+        }
+        ::close(fd);
+        return length == 0;
+    }
+
+    static bool sameEntry(const Xauth *a, const Xauth *b) {
+        return a->family == b->family &&
+               a->address_length == b->address_length &&
+               a->number_length == b->number_length &&
+               a->name_length == b->name_length &&
+               memcmp(a->address, b->address, a->address_length) == 0 &&
+               memcmp(a->number, b->number, a->number_length) == 0 &&
+               memcmp(a->name, b->name, a->name_length) == 0;
+    }
+
+    QString XAuth::generateCookie() {
+        char random[COOKIE_LENGTH];
+        if (!readRandom(random, sizeof(random))) {
+            qCCritical(SDDM_AUTH) << "Failed to read random data for the X authority cookie:" << strerror(errno);
+            return QString();
+        }
+
+        return QString::fromLatin1(QByteArray(random, sizeof(random)).toHex());
+    }
+
+    bool XAuth::addCookie(const QString &file, const QString &display, const QString &cookie) {
+        QByteArray cookieBinary = QByteArray::fromHex(cookie.toLatin1());
+        if (cookieBinary.isEmpty())
+            return false;
+
+        char localhost[HOST_NAME_MAX + 1] = { 0 };
+        if (gethostname(localhost, HOST_NAME_MAX) < 0)
+            strcpy(localhost, "localhost");
+
+        // ":0.1" is display 0, screen 1
+        QByteArray number = display.mid(display.indexOf(QLatin1Char(':')) + 1).section(QLatin1Char('.'), 0, 0).toLatin1();
+
+        Xauth local = { 0 };
+        local.family = FamilyLocal;
+        local.address = localhost;
+        local.address_length = strlen(localhost);
+        local.number = number.data();
+        local.number_length = number.length();
+        local.name = const_cast<char *>(cookieName);
+        local.name_length = strlen(cookieName);
+        local.data = cookieBinary.data();
+        local.data_length = cookieBinary.length();
+
+        // for clients which connect using another hostname
+        Xauth wild = local;
+        wild.family = FamilyWild;
+        wild.address = nullptr;
+        wild.address_length = 0;
+
+        const QByteArray path = QFile::encodeName(file);
+        QByteArray tempPath = path + ".XXXXXX";
+
+        int fd = ::mkostemp(tempPath.data(), O_CLOEXEC);
+        if (fd < 0) {
+            qCCritical(SDDM_AUTH, "Failed to create a temporary file for %s: %s", path.constData(), strerror(errno));
+            return false;
+        }
+        ::fchmod(fd, S_IRUSR | S_IWUSR);
+
+        FILE *fp = ::fdopen(fd, "w");
+        if (!fp) {
+            ::close(fd);
+            ::unlink(tempPath.constData());
+            return false;
+        }
+
+        bool ok = XauWriteAuth(fp, &local) && XauWriteAuth(fp, &wild);
+
+        // keep whatever else was in there
+        if (FILE *old = ::fopen(path.constData(), "re")) {
+            while (Xauth *entry = XauReadAuth(old)) {
+                if (ok && !sameEntry(entry, &local) && !sameEntry(entry, &wild))
+                    ok = XauWriteAuth(fp, entry);
+                XauDisposeAuth(entry);
+            }
+            ::fclose(old);
+        }
+
+        if (::fclose(fp) != 0)
+            ok = false;
+
+        if (!ok || ::rename(tempPath.constData(), path.constData()) != 0) {
+            qCCritical(SDDM_AUTH, "Failed to write the X authority file %s: %s", path.constData(), strerror(errno));
+            ::unlink(tempPath.constData());
+            return false;
+        }
+
+        return true;
+    }
+}
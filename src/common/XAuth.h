@@ -0,0 +1,59 @@
+/*
+ * X authority file writer
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_XAUTH_H
+#define SDDM_XAUTH_H
+
+#include <QtCore/QString>
+
+namespace SDDM {
+    /**
+    * \brief
+    * MIT-MAGIC-COOKIE-1 generation and Xauthority files, without xauth
+    *
+    * \section description
+    * Files are written with libXau to a temporary file next to the target
+    * which is then renamed over it, so the X server and clients never see
+    * a half written file. Entries for other displays are kept, the ones
+    * being added replace any existing entry for the same display.
+    *
+    * The file is created with the credentials of the calling process, the
+    * helper calls it in the session's process once it runs as the user.
+    * It allocates and logs like any Qt code, so it's not async-signal-safe.
+    */
+    class XAuth {
+    public:
+        /**
+        * 16 random bytes from the kernel, as 32 hex digits
+        */
+        static QString generateCookie();
+
+        /**
+        * Adds local and wildcard entries for \a display to \a file
+        * @param file Xauthority file, created with mode 0600 if needed
+        * @param display display name like ":0", empty to match any display
+        * @param cookie cookie as returned by \ref generateCookie
+        * @return false if the file couldn't be written, it is left untouched
+        */
+        static bool addCookie(const QString &file, const QString &display, const QString &cookie);
+    };
+}
+
+#endif // SDDM_XAUTH_H
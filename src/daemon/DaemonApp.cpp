@@ -22,14 +22,16 @@
 #include "Configuration.h"
 #include "Constants.h"
 #include "DisplayManager.h"
+#include "GreeterSnapshotCache.h"
+#include "LoggingCategories.h"
 #include "PowerManager.h"
 #include "SeatManager.h"
 #include "SignalHandler.h"
+#include "StartupTrace.h"
 
 #include "MessageHandler.h"
 
 #include <QDebug>
-#include <QHostInfo>
 #include <QTimer>
 
 #include <iostream>
@@ -43,18 +45,30 @@ namespace SDDM {
 
         qInstallMessageHandler(SDDM::DaemonMessageHandler);
 
+        // filter by category as configured, can be changed over D-Bus
+        setLoggingRules(mainConfig.LoggingRules.get());
+
         // log message
-        qDebug() << "Initializing...";
+        qCDebug(SDDM_DAEMON) << "Initializing...";
 
         // set testing parameter
         m_testing = (arguments().indexOf(QStringLiteral("--test-mode")) != -1);
 
+        // record the startup timeline
+        int traceIndex = arguments().indexOf(QStringLiteral("--trace"));
+        if (traceIndex != -1 && traceIndex < arguments().size() - 1)
+            StartupTrace::start(arguments().at(traceIndex + 1));
+        StartupTrace::Span span(QStringLiteral("DaemonApp"));
+
         // create display manager
         m_displayManager = new DisplayManager(this);
 
         // create power manager
         m_powerManager = new PowerManager(this);
 
+        // create the cache of what greeters are sent
+        m_greeterSnapshotCache = new GreeterSnapshotCache(this);
+
         // create seat manager
         m_seatManager = new SeatManager(this);
 
@@ -74,10 +88,10 @@ namespace SDDM {
         connect(m_signalHandler, SIGNAL(sigtermReceived()), this, SLOT(quit()));
 
         // log message
-        qDebug() << "Starting...";
+        qCDebug(SDDM_DAEMON) << "Starting...";
 
-        // add a seat
-        m_seatManager->createSeat(QStringLiteral("seat0"));
+        // add the seats
+        m_seatManager->initialize();
     }
 
     bool DaemonApp::testing() const {
@@ -86,13 +100,17 @@ namespace SDDM {
 
 
     QString DaemonApp::hostName() const {
-        return QHostInfo::localHostName();
+        return m_greeterSnapshotCache->hostName();
     }
 
     DisplayManager *DaemonApp::displayManager() const {
         return m_displayManager;
     }
 
+    GreeterSnapshotCache *DaemonApp::greeterSnapshotCache() const {
+        return m_greeterSnapshotCache;
+    }
+
     PowerManager *DaemonApp::powerManager() const {
         return m_powerManager;
     }
@@ -120,6 +138,7 @@ int main(int argc, char **argv) {
         std::cout << "Usage: sddm [options]\n"
                   << "Options: \n"
                   << "  --test-mode         Start daemon in test mode" << std::endl
+                  << "  --trace <file>      Record the startup timeline as a Chrome trace to <file>" << std::endl
                   << "  --example-config    Print the complete current configuration to stdout" << std::endl;
 
         return EXIT_FAILURE;
@@ -27,6 +27,7 @@
 namespace SDDM {
     class Configuration;
     class DisplayManager;
+    class GreeterSnapshotCache;
     class PowerManager;
     class SeatManager;
     class SignalHandler;
@@ -45,6 +46,7 @@ namespace SDDM {
 
         QString hostName() const;
         DisplayManager *displayManager() const;
+        GreeterSnapshotCache *greeterSnapshotCache() const;
         PowerManager *powerManager() const;
         SeatManager *seatManager() const;
         SignalHandler *signalHandler() const;
@@ -59,6 +61,7 @@ namespace SDDM {
 
         bool m_testing { false };
         DisplayManager *m_displayManager { nullptr };
+        GreeterSnapshotCache *m_greeterSnapshotCache { nullptr };
         PowerManager *m_powerManager { nullptr };
         SeatManager *m_seatManager { nullptr };
         SignalHandler *m_signalHandler { nullptr };
@@ -24,12 +24,15 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "DisplayManager.h"
+#include "LoggingCategories.h"
 #include "XorgDisplayServer.h"
 #include "Seat.h"
 #include "SocketServer.h"
 #include "Greeter.h"
+#include "GreeterSnapshotCache.h"
 #include "Utils.h"
 #include "SignalHandler.h"
+#include "StartupTrace.h"
 #include "VirtualTerminal.h"
 
 #include <QDebug>
@@ -39,6 +42,9 @@
 #include <pwd.h>
 #include <unistd.h>
 
+// a prepared login nobody comes back to only holds on to a helper
+#define PREPARED_LOGIN_TIMEOUT (5 * 60 * 1000)
+
 namespace SDDM {
     Display::Display(const int terminalId, Seat *parent) : QObject(parent),
         m_terminalId(terminalId),
@@ -46,24 +52,32 @@ namespace SDDM {
         m_displayServer(new XorgDisplayServer(this)),
         m_seat(parent),
         m_socketServer(new SocketServer(this)),
-        m_greeter(new Greeter(this)) {
+        m_greeter(new Greeter(this)),
+        m_prepareTimeout(new QTimer(this)) {
 
         // respond to authentication requests
         m_auth->setVerbose(true);
-        connect(m_auth, SIGNAL(requestChanged()), this, SLOT(slotRequestChanged()));
-        connect(m_auth, SIGNAL(authentication(QString,bool)), this, SLOT(slotAuthenticationFinished(QString,bool)));
-        connect(m_auth, SIGNAL(session(bool)), this, SLOT(slotSessionStarted(bool)));
-        connect(m_auth, SIGNAL(finished(Auth::HelperExitStatus)), this, SLOT(slotHelperFinished(Auth::HelperExitStatus)));
-        connect(m_auth, SIGNAL(info(QString,Auth::Info)), this, SLOT(slotAuthInfo(QString,Auth::Info)));
-        connect(m_auth, SIGNAL(error(QString,Auth::Error)), this, SLOT(slotAuthError(QString,Auth::Error)));
+        m_auth->setHelperPool(m_seat->helperPool());
+        connectAuth();
+
+        m_prepareTimeout->setSingleShot(true);
+        m_prepareTimeout->setInterval(PREPARED_LOGIN_TIMEOUT);
+        connect(m_prepareTimeout, SIGNAL(timeout()), this, SLOT(cancelPreparedLogin()));
 
         // restart display after display server ended
         connect(m_displayServer, SIGNAL(started()), this, SLOT(displayServerStarted()));
+        connect(m_displayServer, SIGNAL(failed()), this, SLOT(displayServerFailed()));
+        connect(m_displayServer, SIGNAL(ready()), this, SLOT(displayServerReady()));
         connect(m_displayServer, SIGNAL(stopped()), this, SLOT(stop()));
 
+        // Wayland sessions wait for their VT
+        connect(VirtualTerminal::Switcher::instance(), SIGNAL(jumped(int,bool)), this, SLOT(vtJumped(int,bool)));
+
         // connect login signal
-        connect(m_socketServer, SIGNAL(login(QLocalSocket*,QString,QString,Session)),
-                this, SLOT(login(QLocalSocket*,QString,QString,Session)));
+        connect(m_socketServer, SIGNAL(login(QLocalSocket*,QString,QString,Session,LoginTrace)),
+                this, SLOT(login(QLocalSocket*,QString,QString,Session,LoginTrace)));
+        connect(m_socketServer, SIGNAL(prepareLogin(QString)), this, SLOT(prepareLogin(QString)));
+        connect(m_socketServer, SIGNAL(connected()), this, SIGNAL(greeterConnected()));
 
         // connect login result signals
         connect(this, SIGNAL(loginFailed(QLocalSocket*)), m_socketServer, SLOT(loginFailed(QLocalSocket*)));
@@ -74,6 +88,15 @@ namespace SDDM {
         stop();
     }
 
+    void Display::connectAuth() {
+        connect(m_auth, SIGNAL(requestChanged()), this, SLOT(slotRequestChanged()));
+        connect(m_auth, SIGNAL(authentication(QString,bool)), this, SLOT(slotAuthenticationFinished(QString,bool)));
+        connect(m_auth, SIGNAL(session(bool)), this, SLOT(slotSessionStarted(bool)));
+        connect(m_auth, SIGNAL(finished(Auth::HelperExitStatus)), this, SLOT(slotHelperFinished(Auth::HelperExitStatus)));
+        connect(m_auth, SIGNAL(info(QString,Auth::Info)), this, SLOT(slotAuthInfo(QString,Auth::Info)));
+        connect(m_auth, SIGNAL(error(QString,Auth::Error)), this, SLOT(slotAuthError(QString,Auth::Error)));
+    }
+
     QString Display::displayId() const {
         return m_displayServer->display();
     }
@@ -94,15 +117,66 @@ namespace SDDM {
         return m_seat;
     }
 
+    bool Display::isStandby() const {
+        return m_standby;
+    }
+
+    void Display::setStandby(bool on) {
+        m_standby = on;
+    }
+
+    void Display::activate() {
+        m_standby = false;
+        VirtualTerminal::jumpToVt(terminalId());
+    }
+
+    bool Display::isStarted() const {
+        return m_started;
+    }
+
+    static qint64 processResidentMemory(qint64 pid) {
+        if (pid <= 0)
+            return 0;
+
+        // size resident shared text lib data dt, in pages
+        QFile statm(QStringLiteral("/proc/%1/statm").arg(pid));
+        if (!statm.open(QIODevice::ReadOnly))
+            return 0;
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() < 2)
+            return 0;
+        return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+
+    qint64 Display::residentMemory() const {
+        qint64 used = processResidentMemory(qobject_cast<XorgDisplayServer *>(m_displayServer)->processId());
+        for (qint64 pid : m_socketServer->greeterProcessIds())
+            used += processResidentMemory(pid);
+        return used;
+    }
+
     void Display::start() {
         // check flag
         if (m_started)
             return;
 
-        // start display server
-        if (!m_displayServer->start()) {
-            qFatal("Display server failed to start. Exiting");
+        // the X server takes over its VT when it starts
+        if (m_standby)
+            m_returnVt = VirtualTerminal::activeVt();
+
+        // authenticate while the display server is starting, the helper
+        // waits for displayServerReady() before it opens the session
+        if (autologinWanted()) {
+            m_autologinAttempted = true;
+            m_auth->setSessionHeld(true);
+            m_autologinHeld = attemptAutologin();
+            if (!m_autologinHeld)
+                m_auth->setSessionHeld(false);
         }
+
+        // start display server
+        if (!m_displayServer->start())
+            displayServerFailed();
     }
 
     bool Display::attemptAutologin() {
@@ -119,32 +193,95 @@ namespace SDDM {
         } else if (findSessionEntry(mainConfig.Wayland.SessionDir.get(), autologinSession)) {
             sessionType = Session::WaylandSession;
         } else {
-            qCritical() << "Unable to find autologin session entry" << autologinSession;
+            qCCritical(SDDM_DISPLAY) << "Unable to find autologin session entry" << autologinSession;
             return false;
         }
 
         Session session;
         session.setTo(sessionType, autologinSession);
 
+        LoginTrace trace(LoginTrace::newId());
+        trace.setUser(mainConfig.Autologin.User.get());
+        trace.mark(QStringLiteral("Display::attemptAutologin"));
+        m_auth->setLoginTrace(trace);
+
         m_auth->setAutologin(true);
         startAuth(mainConfig.Autologin.User.get(), QString(), session);
 
         return true;
     }
 
+    bool Display::autologinWanted() const {
+        return !m_standby && (daemonApp->first || mainConfig.Autologin.Relogin.get()) &&
+               !mainConfig.Autologin.User.get().isEmpty();
+    }
+
     void Display::displayServerStarted() {
         // check flag
         if (m_started)
             return;
 
-        // setup display
+        // log message
+        qCDebug(SDDM_DISPLAY) << "Display server started.";
+
+        // give the screen back right away, unless it was activated meanwhile
+        if (m_standby && m_returnVt > 0 && m_returnVt != terminalId())
+            VirtualTerminal::jumpToVt(m_returnVt);
+
+        // setup display, continues in displayServerReady()
         m_displayServer->setupDisplay();
+    }
 
-        // log message
-        qDebug() << "Display server started.";
+    void Display::displayServerFailed() {
+        // a standby display is only nice to have
+        if (m_standby) {
+            qCWarning(SDDM_DISPLAY) << "Standby display server failed to start";
+            emit stopped();
+            return;
+        }
+
+        // the other seats, and whoever is logged in there, carry on
+        qCCritical(SDDM_DISPLAY) << "Display server on vt" << terminalId() << "failed to start";
+        emit failed();
+    }
+
+    void Display::displayServerReady() {
+        // check flag
+        if (m_started && !m_restarting)
+            return;
+        m_restarting = false;
+
+        bool attempted = m_autologinAttempted;
+        m_autologinAttempted = false;
+
+        if (m_autologinHeld) {
+            m_autologinHeld = false;
 
-        if ((daemonApp->first || mainConfig.Autologin.Relogin.get()) &&
-            !mainConfig.Autologin.User.get().isEmpty()) {
+            // reset first flag
+            daemonApp->first = false;
+
+            // set flags
+            m_started = true;
+
+            // the display is known by now, the session can be opened on it
+            if (m_lastSession.xdgSessionType() == QLatin1String("x11")) {
+                QProcessEnvironment env;
+                env.insert(QStringLiteral("DISPLAY"), name());
+                m_auth->insertEnvironment(env);
+            }
+
+            // released once the session's VT is active
+            if (m_lastSession.xdgSessionType() == QLatin1String("wayland") &&
+                m_auth->isAuthenticated() && m_seat->hasVirtualTerminals())
+                switchToSessionVt();
+            else
+                m_auth->releaseSession();
+
+            emit started();
+            return;
+        }
+
+        if (!attempted && autologinWanted()) {
             // reset first flag
             daemonApp->first = false;
 
@@ -153,6 +290,7 @@ namespace SDDM {
 
             bool success = attemptAutologin();
             if (success) {
+                emit started();
                 return;
             }
         }
@@ -165,7 +303,7 @@ namespace SDDM {
             struct passwd *pw = getpwnam("sddm");
             if (pw) {
                 if (chown(qPrintable(m_socketServer->socketAddress()), pw->pw_uid, pw->pw_gid) == -1) {
-                    qWarning() << "Failed to change owner of the socket";
+                    qCWarning(SDDM_DISPLAY) << "Failed to change owner of the socket";
                     return;
                 }
             }
@@ -175,16 +313,21 @@ namespace SDDM {
         m_greeter->setDisplay(this);
         m_greeter->setAuthPath(qobject_cast<XorgDisplayServer *>(m_displayServer)->authPath());
         m_greeter->setSocket(m_socketServer->socketAddress());
-        m_greeter->setTheme(findGreeterTheme());
+        const QString theme = findGreeterTheme();
+        m_greeter->setTheme(theme);
+        m_socketServer->setTheme(theme);
 
         // start greeter
         m_greeter->start();
 
         // reset first flag
-        daemonApp->first = false;
+        if (!m_standby)
+            daemonApp->first = false;
 
         // set flags
         m_started = true;
+
+        emit started();
     }
 
     void Display::stop() {
@@ -195,6 +338,10 @@ namespace SDDM {
         // stop the greeter
         m_greeter->stop();
 
+        // nobody is going to log in here anymore
+        cancelPreparedLogin();
+        releaseSessionVt();
+
         // stop socket server
         m_socketServer->stop();
 
@@ -212,7 +359,7 @@ namespace SDDM {
 
     void Display::login(QLocalSocket *socket,
                         const QString &user, const QString &password,
-                        const Session &session) {
+                        const Session &session, const LoginTrace &trace) {
         m_socket = socket;
 
         //the SDDM user has special privileges that skip password checking so that we can load the greeter
@@ -222,9 +369,86 @@ namespace SDDM {
         }
 
         // authenticate
+        m_auth->setLoginTrace(trace);
         startAuth(user, password, session);
     }
 
+    void Display::prepareLogin(const QString &user) {
+        if (user == m_preparedUser && m_preparedAuth)
+            return;
+
+        // another user got focused, or none
+        cancelPreparedLogin();
+
+        if (user.isEmpty() || user == QLatin1String("sddm") || m_socket)
+            return;
+
+        // the helper picks its PAM service depending on whether a session
+        // is going to be started, the one actually chosen replaces this
+        // placeholder once the user is authenticated
+        QString lastSession = stateConfig.Last.Session.get();
+        Session session;
+        if (findSessionEntry(mainConfig.X11.SessionDir.get(), lastSession))
+            session.setTo(Session::X11Session, lastSession);
+        else if (findSessionEntry(mainConfig.Wayland.SessionDir.get(), lastSession))
+            session.setTo(Session::WaylandSession, lastSession);
+        if (session.exec().isEmpty())
+            return;
+
+        qCDebug(SDDM_DISPLAY) << "Preparing login of" << user;
+
+        // start PAM and let it wait for the password, requests are held
+        // back until the credentials arrive
+        m_preparedUser = user;
+        m_preparedAuth = new Auth(this);
+        m_preparedAuth->setVerbose(true);
+        m_preparedAuth->setHelperPool(m_seat->helperPool());
+        m_preparedAuth->setUser(user);
+        m_preparedAuth->setSession(session.exec());
+        connect(m_preparedAuth, SIGNAL(finished(Auth::HelperExitStatus)), this, SLOT(cancelPreparedLogin()));
+        m_preparedAuth->start();
+
+        m_prepareTimeout->start();
+    }
+
+    void Display::cancelPreparedLogin() {
+        m_prepareTimeout->stop();
+        m_preparedUser.clear();
+
+        if (!m_preparedAuth)
+            return;
+
+        qCDebug(SDDM_DISPLAY) << "Cancelling prepared login";
+
+        // nothing has been opened yet, the helper can just go away
+        m_preparedAuth->disconnect(this);
+        m_preparedAuth->deleteLater();
+        m_preparedAuth = nullptr;
+    }
+
+    bool Display::adoptPreparedLogin(const QString &user) {
+        if (!m_preparedAuth || m_preparedUser != user || m_auth->autologin()) {
+            cancelPreparedLogin();
+            return false;
+        }
+
+        qCDebug(SDDM_DISPLAY) << "Using the prepared login of" << user;
+
+        m_prepareTimeout->stop();
+        m_preparedUser.clear();
+
+        m_preparedAuth->disconnect(this);
+        m_preparedAuth->setLoginTrace(m_auth->loginTrace());
+
+        m_auth->disconnect(this);
+        m_auth->deleteLater();
+        m_auth = m_preparedAuth;
+        m_preparedAuth = nullptr;
+        connectAuth();
+
+        return true;
+    }
+
     QString Display::findGreeterTheme() const {
         QString themeName = mainConfig.Theme.Current.get();
 
@@ -240,7 +464,7 @@ namespace SDDM {
             return dir.absoluteFilePath(themeName);
 
         // otherwise use the embedded theme
-        qWarning() << "The configured theme" << themeName << "doesn't exist, using the embedded theme instead";
+        qCWarning(SDDM_DISPLAY) << "The configured theme" << themeName << "doesn't exist, using the embedded theme instead";
         return QString();
     }
 
@@ -260,15 +484,15 @@ namespace SDDM {
 
         // sanity check
         if (!session.isValid()) {
-            qCritical() << "Invalid session" << session.fileName();
+            qCCritical(SDDM_DISPLAY) << "Invalid session" << session.fileName();
             return;
         }
         if (session.xdgSessionType().isEmpty()) {
-            qCritical() << "Failed to find XDG session type for session" << session.fileName();
+            qCCritical(SDDM_DISPLAY) << "Failed to find XDG session type for session" << session.fileName();
             return;
         }
         if (session.exec().isEmpty()) {
-            qCritical() << "Failed to find command for session" << session.fileName();
+            qCCritical(SDDM_DISPLAY) << "Failed to find command for session" << session.fileName();
             return;
         }
 
@@ -280,12 +504,19 @@ namespace SDDM {
         m_sessionName = session.fileName();
 
         // some information
-        qDebug() << "Session" << m_sessionName << "selected, command:" << session.exec();
+        qCDebug(SDDM_DISPLAY) << "Session" << m_sessionName << "selected, command:" << session.exec();
+
+        // take over the helper which started while the password was typed
+        bool prepared = adoptPreparedLogin(user);
 
         // create new VT for Wayland sessions otherwise use greeter vt
         int vt = terminalId();
-        if (session.xdgSessionType() == QLatin1String("wayland"))
-            vt = VirtualTerminal::setUpNewVt();
+        releaseSessionVt();
+        if (session.xdgSessionType() == QLatin1String("wayland") && m_seat->hasVirtualTerminals()) {
+            m_sessionVt = VirtualTerminal::Allocator::instance()->allocate(QStringLiteral("session %1").arg(user));
+            if (m_sessionVt > 0)
+                vt = m_sessionVt;
+        }
         m_lastSession.setVt(vt);
 
         QProcessEnvironment env;
@@ -295,7 +526,8 @@ namespace SDDM {
         env.insert(QStringLiteral("XDG_SEAT"), seat()->name());
         env.insert(QStringLiteral("XDG_SEAT_PATH"), daemonApp->displayManager()->seatPath(seat()->name()));
         env.insert(QStringLiteral("XDG_SESSION_PATH"), daemonApp->displayManager()->sessionPath(QStringLiteral("Session%1").arg(daemonApp->newSessionId())));
-        env.insert(QStringLiteral("XDG_VTNR"), QString::number(vt));
+        if (m_seat->hasVirtualTerminals())
+            env.insert(QStringLiteral("XDG_VTNR"), QString::number(vt));
         env.insert(QStringLiteral("DESKTOP_SESSION"), session.desktopSession());
         env.insert(QStringLiteral("XDG_CURRENT_DESKTOP"), session.desktopNames());
         env.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("user"));
@@ -305,12 +537,17 @@ namespace SDDM {
 
         m_auth->setUser(user);
         m_auth->setSession(session.exec());
-        m_auth->start();
+
+        // PAM is most likely waiting for the password already
+        if (prepared)
+            slotRequestChanged();
+        else
+            m_auth->start();
     }
 
     void Display::slotAuthenticationFinished(const QString &user, bool success) {
         if (success) {
-            qDebug() << "Authenticated successfully";
+            qCDebug(SDDM_DISPLAY) << "Authenticated successfully";
 
             m_auth->setCookie(qobject_cast<XorgDisplayServer *>(m_displayServer)->cookie());
 
@@ -324,29 +561,56 @@ namespace SDDM {
             else
                 stateConfig.Last.Session.setDefault();
             stateConfig.save();
+            daemonApp->greeterSnapshotCache()->invalidate();
 
-            // switch to the new VT for Wayland sessions
-            if (m_lastSession.xdgSessionType() == QLatin1String("wayland"))
-                VirtualTerminal::jumpToVt(m_lastSession.vt());
+            // switch to the new VT for Wayland sessions, the display server
+            // would take it back if it's still starting
+            if (m_lastSession.xdgSessionType() == QLatin1String("wayland") && !m_autologinHeld &&
+                m_seat->hasVirtualTerminals())
+                switchToSessionVt();
 
             if (m_socket)
                 emit loginSucceeded(m_socket);
         } else if (m_socket) {
-            qDebug() << "Authentication failure";
+            qCDebug(SDDM_DISPLAY) << "Authentication failure";
             emit loginFailed(m_socket);
         }
         m_socket = nullptr;
     }
 
+    void Display::releaseSessionVt() {
+        if (m_sessionVt > 0)
+            VirtualTerminal::Allocator::instance()->release(m_sessionVt);
+        m_sessionVt = -1;
+    }
+
+    void Display::switchToSessionVt() {
+        // the compositor expects its VT to be active when it starts, the
+        // helper waits with opening the session until the switch is done
+        m_auth->setSessionHeld(true);
+        m_sessionVtPending = true;
+        VirtualTerminal::jumpToVt(m_lastSession.vt());
+    }
+
+    void Display::vtJumped(int vt, bool success) {
+        if (!m_sessionVtPending || vt != m_lastSession.vt())
+            return;
+        m_sessionVtPending = false;
+
+        if (!success)
+            qCWarning(SDDM_DISPLAY) << "Starting the session without its VT" << vt << "being active";
+        m_auth->releaseSession();
+    }
+
     void Display::slotAuthInfo(const QString &message, Auth::Info info) {
         // TODO: presentable to the user, eventually
         Q_UNUSED(info);
-        qWarning() << "Authentication information:" << message;
+        qCWarning(SDDM_DISPLAY) << "Authentication information:" << message;
     }
 
     void Display::slotAuthError(const QString &message, Auth::Error error) {
         // TODO: handle more errors
-        qWarning() << "Authentication error:" << message;
+        qCWarning(SDDM_DISPLAY) << "Authentication error:" << message;
 
         if (!m_socket)
             return;
@@ -356,13 +620,64 @@ namespace SDDM {
     }
 
     void Display::slotHelperFinished(Auth::HelperExitStatus status) {
+        // the session is over, or never started
+        releaseSessionVt();
+
+        if (m_autologinHeld) {
+            // autologin failed before the display server was ready, the
+            // greeter is started instead
+            qCWarning(SDDM_DISPLAY) << "Autologin failed";
+            m_autologinHeld = false;
+            m_auth->setSessionHeld(false);
+            return;
+        }
+
         // Don't restart greeter and display server unless sddm-helper exited
         // with an internal error or the user session finished successfully,
         // we want to avoid greeter from restarting when an authentication
         // error happens (in this case we want to show the message from the
         // greeter
-        if (status != Auth::HELPER_AUTH_ERROR)
-            stop();
+        if (status == Auth::HELPER_AUTH_ERROR)
+            return;
+
+        if (mainConfig.X11.ReuseServer.get() && restartGreeter())
+            return;
+
+        stop();
+    }
+
+    bool Display::restartGreeter() {
+        if (!m_started)
+            return false;
+
+        // new cookie, and no client of the last session left connected
+        if (!m_displayServer->reset())
+            return false;
+
+        qCDebug(SDDM_DISPLAY) << "Restarting the greeter on display" << name();
+
+        m_greeter->stop();
+        cancelPreparedLogin();
+        m_socketServer->stop();
+
+        // start over with a clean authenticator, no environment, autologin
+        // flag or helper of the last session carried over
+        m_auth->disconnect(this);
+        m_auth->deleteLater();
+        m_auth = new Auth(this);
+        m_auth->setVerbose(true);
+        m_auth->setHelperPool(m_seat->helperPool());
+        connectAuth();
+
+        // Wayland sessions ran on their own VT
+        if (m_lastSession.xdgSessionType() == QLatin1String("wayland") && m_seat->hasVirtualTerminals())
+            VirtualTerminal::jumpToVt(terminalId());
+
+        // the display server sets the display up again once it's done
+        // resetting, continues in displayServerReady()
+        m_restarting = true;
+
+        return true;
     }
 
     void Display::slotRequestChanged() {
@@ -377,6 +692,22 @@ namespace SDDM {
     }
 
     void Display::slotSessionStarted(bool success) {
-        qDebug() << "Session started";
+        qCDebug(SDDM_DISPLAY) << "Session started";
+
+        // the session has its VT open now
+        if (success && m_sessionVt > 0)
+            VirtualTerminal::Allocator::instance()->handOver(m_sessionVt);
+
+        // report how long it took to get here
+        const LoginTrace &trace = m_auth->loginTrace();
+        if (success && !trace.isEmpty()) {
+            QString breakdown = trace.toString();
+            qCInfo(SDDM_DISPLAY) << "Login trace:" << qPrintable(breakdown);
+            daemonApp->displayManager()->AddLoginTrace(breakdown);
+        }
+
+        // next to the display server start, to see what overlapped
+        if (success)
+            StartupTrace::addPhases(trace, QStringLiteral("sddm-helper"), terminalId());
     }
 }
@@ -29,6 +29,7 @@
 #include "Session.h"
 
 class QLocalSocket;
+class QTimer;
 
 namespace SDDM {
     class Authenticator;
@@ -53,18 +54,45 @@ namespace SDDM {
 
         Seat *seat() const;
 
+        /**
+        * A standby display starts its X server and greeter without staying
+        * on their VT, and never logs anyone in automatically, until it's
+        * \ref activate "activated"
+        */
+        bool isStandby() const;
+        void setStandby(bool on);
+        void activate();
+
+        bool isStarted() const;
+
+        /**
+        * Resident memory of the display server and of the greeters
+        * connected to it, in bytes
+        */
+        qint64 residentMemory() const;
+
     public slots:
         void start();
         void stop();
 
         void login(QLocalSocket *socket,
                    const QString &user, const QString &password,
-                   const Session &session);
+                   const Session &session, const LoginTrace &trace);
+        void prepareLogin(const QString &user);
         bool attemptAutologin();
         void displayServerStarted();
+        void displayServerFailed();
+        void displayServerReady();
 
     signals:
+        void started();
         void stopped();
+        void failed();
+
+        /**
+        * A greeter connected to the socket, its process is up
+        */
+        void greeterConnected();
 
         void loginFailed(QLocalSocket *socket);
         void loginSucceeded(QLocalSocket *socket);
@@ -76,8 +104,22 @@ namespace SDDM {
         void startAuth(const QString &user, const QString &password,
                        const Session &session);
 
+        void connectAuth();
+        bool adoptPreparedLogin(const QString &user);
+        bool restartGreeter();
+        bool autologinWanted() const;
+        void switchToSessionVt();
+        void releaseSessionVt();
+
         bool m_relogin { true };
         bool m_started { false };
+        bool m_restarting { false };
+        bool m_standby { false };
+        bool m_autologinHeld { false };
+        bool m_autologinAttempted { false };
+        bool m_sessionVtPending { false };
+        int m_returnVt { -1 };
+        int m_sessionVt { -1 };
 
         int m_terminalId { 7 };
 
@@ -87,6 +129,9 @@ namespace SDDM {
         QString m_sessionName;
 
         Auth *m_auth { nullptr };
+        Auth *m_preparedAuth { nullptr };
+        QString m_preparedUser;
+        QTimer *m_prepareTimeout { nullptr };
         DisplayServer *m_displayServer { nullptr };
         Seat *m_seat { nullptr };
         SocketServer *m_socketServer { nullptr };
@@ -94,10 +139,12 @@ namespace SDDM {
         Greeter *m_greeter { nullptr };
 
     private slots:
+        void cancelPreparedLogin();
         void slotRequestChanged();
         void slotAuthenticationFinished(const QString &user, bool success);
         void slotSessionStarted(bool success);
         void slotHelperFinished(Auth::HelperExitStatus status);
+        void vtJumped(int vt, bool success);
         void slotAuthInfo(const QString &message, Auth::Info info);
         void slotAuthError(const QString &message, Auth::Error error);
     };
@@ -19,8 +19,11 @@
 
 #include "DisplayManager.h"
 
+#include "Configuration.h"
 #include "DaemonApp.h"
+#include "LoggingCategories.h"
 #include "SeatManager.h"
+#include "VirtualTerminal.h"
 
 #include "displaymanageradaptor.h"
 #include "seatadaptor.h"
@@ -31,8 +34,12 @@ const QString DISPLAYMANAGER_PATH = QStringLiteral("/org/freedesktop/DisplayMana
 const QString DISPLAYMANAGER_SEAT_PATH = QStringLiteral("/org/freedesktop/DisplayManager/Seat");
 const QString DISPLAYMANAGER_SESSION_PATH = QStringLiteral("/org/freedesktop/DisplayManager/Session");
 
+// how many of the most recent login traces are kept
+const int MAX_LOGIN_TRACES = 16;
+
 namespace SDDM {
-    DisplayManager::DisplayManager(QObject *parent) : QObject(parent) {
+    DisplayManager::DisplayManager(QObject *parent) : QObject(parent),
+        m_loggingRules(mainConfig.LoggingRules.get()) {
         // create adaptor
         new DisplayManagerAdaptor(this);
 
@@ -69,6 +76,18 @@ namespace SDDM {
         return sessions;
     }
 
+    QStringList DisplayManager::LoginTraces() const {
+        return m_loginTraces;
+    }
+
+    QStringList DisplayManager::VirtualTerminals() const {
+        return VirtualTerminal::Allocator::instance()->usage();
+    }
+
+    QStringList DisplayManager::LoggingRules() const {
+        return m_loggingRules;
+    }
+
     void DisplayManager::AddSeat(const QString &name) {
         // create seat object
         DisplayManagerSeat *seat = new DisplayManagerSeat(name, this);
@@ -129,6 +148,21 @@ namespace SDDM {
         }
     }
 
+    void DisplayManager::AddLoginTrace(const QString &trace) {
+        m_loginTraces << trace;
+
+        // drop the oldest ones
+        while (m_loginTraces.size() > MAX_LOGIN_TRACES)
+            m_loginTraces.removeFirst();
+    }
+
+    void DisplayManager::SetLoggingRules(const QStringList &rules) {
+        qCInfo(SDDM_DAEMON) << "Logging rules changed to" << rules;
+
+        m_loggingRules = rules;
+        setLoggingRules(rules);
+    }
+
     DisplayManagerSeat::DisplayManagerSeat(const QString &name, QObject *parent) : QObject(parent) {
         // set name and path
         m_name = name;
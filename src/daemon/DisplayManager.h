@@ -24,6 +24,7 @@
 
 #include <QDBusObjectPath>
 #include <QList>
+#include <QStringList>
 
 namespace SDDM {
     class DisplayManagerSeat;
@@ -40,6 +41,9 @@ namespace SDDM {
         Q_DISABLE_COPY(DisplayManager)
         Q_PROPERTY(QList<QDBusObjectPath> Seats READ Seats CONSTANT)
         Q_PROPERTY(QList<QDBusObjectPath> Sessions READ Sessions CONSTANT)
+        Q_PROPERTY(QStringList LoginTraces READ LoginTraces)
+        Q_PROPERTY(QStringList VirtualTerminals READ VirtualTerminals)
+        Q_PROPERTY(QStringList LoggingRules READ LoggingRules)
     public:
         DisplayManager(QObject *parent = 0);
 
@@ -48,12 +52,22 @@ namespace SDDM {
 
         ObjectPathList Seats() const;
         ObjectPathList Sessions(DisplayManagerSeat *seat = nullptr) const;
+        QStringList LoginTraces() const;
+        QStringList VirtualTerminals() const;
+        QStringList LoggingRules() const;
 
     public slots:
         void AddSeat(const QString &name);
         void RemoveSeat(const QString &name);
         void AddSession(const QString &name, const QString &seat, const QString &user);
         void RemoveSession(const QString &name);
+        void AddLoginTrace(const QString &trace);
+
+        /**
+        * Replaces the daemon's logging rules until it's restarted, greeters
+        * and helpers started from now on still go with the config file
+        */
+        void SetLoggingRules(const QStringList &rules);
 
     signals:
         void SeatAdded(ObjectPath seat);
@@ -64,6 +78,8 @@ namespace SDDM {
     private:
         QList<DisplayManagerSeat *> m_seats;
         QList<DisplayManagerSession *> m_sessions;
+        QStringList m_loginTraces;
+        QStringList m_loggingRules;
     };
 
     /***************************************************************************
@@ -41,13 +41,37 @@ namespace SDDM {
         virtual QString sessionType() const = 0;
 
     public slots:
+        /**
+        * Begins starting the display server
+        * @return false if it couldn't even be launched
+        */
         virtual bool start() = 0;
         virtual void stop() = 0;
         virtual void finished() = 0;
+        /**
+        * Runs the display setup hooks, \ref ready is emitted once the
+        * greeter can be started
+        */
         virtual void setupDisplay() = 0;
 
+        /**
+        * Brings a running display server back to a pristine state, with a
+        * new cookie, so that it can be reused for the next greeter. Once
+        * it accepts clients again the display is set up as by
+        * \ref setupDisplay, and \ref ready follows. If the reset can't
+        * be seen through the server is stopped instead.
+        * @return false if it isn't running or can't be reset
+        */
+        virtual bool reset() = 0;
+
     signals:
+        /**
+        * start() only begins starting the server, one of these follows
+        */
         void started();
+        void failed();
+
+        void ready();
         void stopped();
 
     protected:
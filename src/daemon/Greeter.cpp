@@ -23,25 +23,21 @@
 #include "Constants.h"
 #include "DaemonApp.h"
 #include "DisplayManager.h"
+#include "GreeterSnapshotCache.h"
+#include "LoggingCategories.h"
 #include "Seat.h"
-#include "ThemeConfig.h"
-#include "ThemeMetadata.h"
 #include "Display.h"
+#include "StartupTrace.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QProcess>
 
 namespace SDDM {
     Greeter::Greeter(QObject *parent) : QObject(parent) {
-        m_metadata = new ThemeMetadata(QString());
-        m_themeConfig = new ThemeConfig(QString());
     }
 
     Greeter::~Greeter() {
         stop();
-
-        delete m_metadata;
-        delete m_themeConfig;
     }
 
     void Greeter::setDisplay(Display *display) {
@@ -59,16 +55,8 @@ namespace SDDM {
     void Greeter::setTheme(const QString &theme) {
         m_themePath = theme;
 
-        if (theme.isEmpty()) {
-            m_metadata->setTo(QString());
-            m_themeConfig->setTo(QString());
-        } else {
-            const QString path = QStringLiteral("%1/metadata.desktop").arg(m_themePath);
-            m_metadata->setTo(path);
-
-            QString configFile = QStringLiteral("%1/%2").arg(m_themePath).arg(m_metadata->configFile());
-            m_themeConfig->setTo(configFile);
-        }
+        // read once for all displays, and ready for when the greeter connects
+        m_themeConfig = daemonApp->greeterSnapshotCache()->snapshot(theme).themeConfig;
     }
 
     bool Greeter::start() {
@@ -78,14 +66,14 @@ namespace SDDM {
 
         // themes
         QString xcursorTheme = mainConfig.Theme.CursorTheme.get();
-        if (m_themeConfig->contains(QLatin1String("cursorTheme")))
-            xcursorTheme = m_themeConfig->value(QLatin1String("cursorTheme")).toString();
+        if (m_themeConfig.contains(QLatin1String("cursorTheme")))
+            xcursorTheme = m_themeConfig.value(QLatin1String("cursorTheme")).toString();
         QString platformTheme;
-        if (m_themeConfig->contains(QLatin1String("platformTheme")))
-            platformTheme = m_themeConfig->value(QLatin1String("platformTheme")).toString();
+        if (m_themeConfig.contains(QLatin1String("platformTheme")))
+            platformTheme = m_themeConfig.value(QLatin1String("platformTheme")).toString();
         QString style;
-        if (m_themeConfig->contains(QLatin1String("style")))
-            style = m_themeConfig->value(QLatin1String("style")).toString();
+        if (m_themeConfig.contains(QLatin1String("style")))
+            style = m_themeConfig.value(QLatin1String("style")).toString();
 
         // greeter command
         QStringList args;
@@ -95,6 +83,8 @@ namespace SDDM {
             args << QLatin1String("-platformtheme") << platformTheme;
         if (!style.isEmpty())
             args << QLatin1String("-style") << style;
+        if (StartupTrace::isEnabled())
+            args << QLatin1String("--trace");
 
         if (daemonApp->testing()) {
             // create process
@@ -107,7 +97,7 @@ namespace SDDM {
             connect(m_process, SIGNAL(readyReadStandardError()), SLOT(onReadyReadStandardError()));
 
             // log message
-            qDebug() << "Greeter starting...";
+            qCDebug(SDDM_DISPLAY) << "Greeter starting...";
 
             // set process environment
             QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -124,20 +114,20 @@ namespace SDDM {
 
             //if we fail to start bail immediately, and don't block in waitForStarted
             if (m_process->state() == QProcess::NotRunning) {
-                qCritical() << "Greeter failed to launch.";
+                qCCritical(SDDM_DISPLAY) << "Greeter failed to launch.";
                 return false;
             }
             // wait for greeter to start
             if (!m_process->waitForStarted()) {
                 // log message
-                qCritical() << "Failed to start greeter.";
+                qCCritical(SDDM_DISPLAY) << "Failed to start greeter.";
 
                 // return fail
                 return false;
             }
 
             // log message
-            qDebug() << "Greeter started.";
+            qCDebug(SDDM_DISPLAY) << "Greeter started.";
 
             // set flag
             m_started = true;
@@ -145,6 +135,7 @@ namespace SDDM {
             // authentication
             m_auth = new Auth(this);
             m_auth->setVerbose(true);
+            m_auth->setHelperPool(m_display->seat()->helperPool());
             connect(m_auth, SIGNAL(requestChanged()), this, SLOT(onRequestChanged()));
             connect(m_auth, SIGNAL(session(bool)), this, SLOT(onSessionStarted(bool)));
             connect(m_auth, SIGNAL(finished(Auth::HelperExitStatus)), this, SLOT(onHelperFinished(Auth::HelperExitStatus)));
@@ -177,7 +168,8 @@ namespace SDDM {
             env.insert(QStringLiteral("XDG_SEAT"), m_display->seat()->name());
             env.insert(QStringLiteral("XDG_SEAT_PATH"), daemonApp->displayManager()->seatPath(m_display->seat()->name()));
             env.insert(QStringLiteral("XDG_SESSION_PATH"), daemonApp->displayManager()->sessionPath(QStringLiteral("Session%1").arg(daemonApp->newSessionId())));
-            env.insert(QStringLiteral("XDG_VTNR"), QString::number(m_display->terminalId()));
+            if (m_display->seat()->hasVirtualTerminals())
+                env.insert(QStringLiteral("XDG_VTNR"), QString::number(m_display->terminalId()));
             env.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("greeter"));
             env.insert(QStringLiteral("XDG_SESSION_TYPE"), m_display->sessionType());
             env.insert(QStringLiteral("QT_IM_MODULE"), mainConfig.InputMethod.get());
@@ -188,9 +180,17 @@ namespace SDDM {
             m_auth->insertEnvironment(env);
 
             // log message
-            qDebug() << "Greeter starting...";
+            qCDebug(SDDM_DISPLAY) << "Greeter starting...";
 
             // start greeter
+            // the helper reports its phases under this trace
+            if (StartupTrace::isEnabled()) {
+                LoginTrace trace(LoginTrace::newId());
+                trace.setUser(QStringLiteral("sddm"));
+                trace.mark(QStringLiteral("Greeter::start"));
+                m_auth->setLoginTrace(trace);
+            }
+
             m_auth->setUser(QStringLiteral("sddm"));
             m_auth->setGreeter(true);
             m_auth->setSession(cmd.join(QLatin1Char(' ')));
@@ -213,7 +213,7 @@ namespace SDDM {
             return;
 
         // log message
-        qDebug() << "Greeter stopping...";
+        qCDebug(SDDM_DISPLAY) << "Greeter stopping...";
 
         if (daemonApp->testing()) {
             // terminate process
@@ -234,7 +234,7 @@ namespace SDDM {
         m_started = false;
 
         // log message
-        qDebug() << "Greeter stopped.";
+        qCDebug(SDDM_DISPLAY) << "Greeter stopped.";
 
         // clean up
         m_process->deleteLater();
@@ -249,11 +249,15 @@ namespace SDDM {
         // set flag
         m_started = success;
 
+        // helper spawn, PAM and session setup of the greeter
+        if (success)
+            StartupTrace::addPhases(m_auth->loginTrace(), QStringLiteral("sddm-helper"), m_display->terminalId());
+
         // log message
         if (success)
-            qDebug() << "Greeter session started successfully";
+            qCDebug(SDDM_DISPLAY) << "Greeter session started successfully";
         else
-            qDebug() << "Greeter session failed to start";
+            qCDebug(SDDM_DISPLAY) << "Greeter session failed to start";
     }
 
     void Greeter::onHelperFinished(Auth::HelperExitStatus status) {
@@ -261,7 +265,7 @@ namespace SDDM {
         m_started = false;
 
         // log message
-        qDebug() << "Greeter stopped.";
+        qCDebug(SDDM_DISPLAY) << "Greeter stopped.";
 
         // clean up
         m_auth->deleteLater();
@@ -271,24 +275,24 @@ namespace SDDM {
     void Greeter::onReadyReadStandardError()
     {
         if (m_process) {
-            qDebug() << "Greeter errors:" << qPrintable(QString::fromLocal8Bit(m_process->readAllStandardError()));
+            qCDebug(SDDM_DISPLAY) << "Greeter errors:" << qPrintable(QString::fromLocal8Bit(m_process->readAllStandardError()));
         }
     }
 
     void Greeter::onReadyReadStandardOutput()
     {
         if (m_process) {
-            qDebug() << "Greeter output:" << qPrintable(QString::fromLocal8Bit(m_process->readAllStandardOutput()));
+            qCDebug(SDDM_DISPLAY) << "Greeter output:" << qPrintable(QString::fromLocal8Bit(m_process->readAllStandardOutput()));
         }
     }
 
     void Greeter::authInfo(const QString &message, Auth::Info info) {
         Q_UNUSED(info);
-        qDebug() << "Information from greeter session:" << message;
+        qCDebug(SDDM_DISPLAY) << "Information from greeter session:" << message;
     }
 
     void Greeter::authError(const QString &message, Auth::Error error) {
         Q_UNUSED(error);
-        qWarning() << "Error from greeter session:" << message;
+        qCWarning(SDDM_DISPLAY) << "Error from greeter session:" << message;
     }
 }
@@ -21,6 +21,7 @@
 #define SDDM_GREETER_H
 
 #include <QObject>
+#include <QVariantMap>
 
 #include "Auth.h"
 
@@ -28,8 +29,6 @@ class QProcess;
 
 namespace SDDM {
     class Display;
-    class ThemeMetadata;
-    class ThemeConfig;
 
     class Greeter : public QObject {
         Q_OBJECT
@@ -64,8 +63,7 @@ namespace SDDM {
         QString m_authPath;
         QString m_socket;
         QString m_themePath;
-        ThemeMetadata *m_metadata { nullptr };
-        ThemeConfig *m_themeConfig { nullptr };
+        QVariantMap m_themeConfig;
 
         Auth *m_auth { nullptr };
         QProcess *m_process { nullptr };
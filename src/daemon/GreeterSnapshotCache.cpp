@@ -0,0 +1,129 @@
+/*
+ * Cache of the greeter's initial state
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "GreeterSnapshotCache.h"
+
+#include "Configuration.h"
+#include "DaemonApp.h"
+#include "LoggingCategories.h"
+#include "PowerManager.h"
+#include "StartupTrace.h"
+#include "ThemeConfig.h"
+#include "ThemeMetadata.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileSystemWatcher>
+#include <QtDBus/QDBusConnection>
+#include <QtNetwork/QHostInfo>
+
+namespace SDDM {
+    GreeterSnapshotCache::GreeterSnapshotCache(QObject *parent) : QObject(parent),
+        m_watcher(new QFileSystemWatcher(this)) {
+        m_snapshot.hostName = QHostInfo::localHostName();
+
+        // editors tend to replace files rather than write to them,
+        // which only shows on the directory
+        connect(m_watcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChanged(QString)));
+        connect(m_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(fileChanged(QString)));
+
+        // hostnamed is started to change the host name, and tells
+        QDBusConnection::systemBus().connect(QStringLiteral("org.freedesktop.hostname1"),
+                                             QStringLiteral("/org/freedesktop/hostname1"),
+                                             QStringLiteral("org.freedesktop.DBus.Properties"),
+                                             QStringLiteral("PropertiesChanged"),
+                                             this, SLOT(hostnamedChanged()));
+    }
+
+    const QString &GreeterSnapshotCache::hostName() {
+        return m_snapshot.hostName;
+    }
+
+    GreeterSnapshot GreeterSnapshotCache::snapshot(const QString &themePath) {
+        if (!m_valid || themePath != m_snapshot.themePath)
+            build(themePath);
+
+        // already cached, and kept up to date, by the power manager
+        GreeterSnapshot snapshot = m_snapshot;
+        snapshot.capabilities = quint32(daemonApp->powerManager()->capabilities());
+        return snapshot;
+    }
+
+    void GreeterSnapshotCache::invalidate() {
+        m_valid = false;
+    }
+
+    void GreeterSnapshotCache::hostnamedChanged() {
+        const QString hostName = QHostInfo::localHostName();
+        if (hostName == m_snapshot.hostName)
+            return;
+
+        m_snapshot.hostName = hostName;
+        emit hostNameChanged(hostName);
+    }
+
+    void GreeterSnapshotCache::fileChanged(const QString &path) {
+        qCDebug(SDDM_DAEMON) << "Greeter theme changed:" << path;
+
+        // read again when the next greeter connects
+        invalidate();
+    }
+
+    void GreeterSnapshotCache::build(const QString &themePath) {
+        StartupTrace::Span span(QStringLiteral("GreeterSnapshotCache::build"));
+
+        m_snapshot.themePath = themePath;
+        m_snapshot.themeConfig.clear();
+
+        // an empty path is the embedded theme, which goes with the defaults
+        if (themePath.isEmpty()) {
+            ThemeMetadata metadata(QString());
+            m_snapshot.mainScript = metadata.mainScript();
+            m_snapshot.translationsDirectory = metadata.translationsDirectory();
+            watch(QStringList());
+        } else {
+            const QString metadataFile = QStringLiteral("%1/metadata.desktop").arg(themePath);
+            ThemeMetadata metadata(metadataFile);
+            m_snapshot.mainScript = metadata.mainScript();
+            m_snapshot.translationsDirectory = metadata.translationsDirectory();
+
+            const QString configFile = QStringLiteral("%1/%2").arg(themePath).arg(metadata.configFile());
+            m_snapshot.themeConfig = ThemeConfig(configFile);
+
+            watch({ themePath, metadataFile, configFile, configFile + QStringLiteral(".user") });
+        }
+
+        m_snapshot.lastUser = stateConfig.Last.User.get();
+        m_snapshot.lastSession = stateConfig.Last.Session.get();
+
+        m_valid = true;
+    }
+
+    void GreeterSnapshotCache::watch(const QStringList &paths) {
+        const QStringList watched = m_watcher->files() + m_watcher->directories();
+        if (!watched.isEmpty())
+            m_watcher->removePaths(watched);
+
+        for (const QString &path : paths) {
+            if (QFile::exists(path))
+                m_watcher->addPath(path);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Cache of the greeter's initial state
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_GREETERSNAPSHOTCACHE_H
+#define SDDM_GREETERSNAPSHOTCACHE_H
+
+#include <QtCore/QObject>
+
+#include "GreeterSnapshot.h"
+
+class QFileSystemWatcher;
+
+namespace SDDM {
+    /**
+    * \brief
+    * Keeps what greeters are sent when they connect
+    *
+    * \section description
+    * The theme is read from disk once and shared by the greeters of all
+    * displays, it's read again when one of its files changes or another
+    * theme is asked for. The host name is looked up again when hostnamed
+    * announces a new one, the capabilities come from the power manager's
+    * own cache, which follows logind, and the last user and session from
+    * the state config, after which \ref invalidate has to be called.
+    */
+    class GreeterSnapshotCache : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(GreeterSnapshotCache)
+    public:
+        explicit GreeterSnapshotCache(QObject *parent = nullptr);
+
+        const QString &hostName();
+
+        /**
+        * The snapshot for a greeter with the theme in \a themePath,
+        * built right away if there's none yet
+        */
+        GreeterSnapshot snapshot(const QString &themePath);
+
+    public slots:
+        void invalidate();
+
+    signals:
+        void hostNameChanged(const QString &hostName);
+
+    private slots:
+        void hostnamedChanged();
+        void fileChanged(const QString &path);
+
+    private:
+        void build(const QString &themePath);
+        void watch(const QStringList &paths);
+
+        QFileSystemWatcher *m_watcher { nullptr };
+        GreeterSnapshot m_snapshot;
+        bool m_valid { false };
+    };
+}
+
+#endif // SDDM_GREETERSNAPSHOTCACHE_H
@@ -0,0 +1,164 @@
+/*
+ * Asynchronous runner for display setup and teardown scripts
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "HookRunner.h"
+#include "LoggingCategories.h"
+#include "StartupTrace.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QProcess>
+#include <QtCore/QTimer>
+
+namespace SDDM {
+    HookRunner::HookRunner(QObject *parent) : QObject(parent) {
+    }
+
+    HookRunner::~HookRunner() {
+        // don't leave anything behind, nor report on it
+        for (Hook &hook : m_hooks) {
+            if (hook.process && hook.process->state() != QProcess::NotRunning) {
+                hook.process->disconnect(this);
+                hook.process->kill();
+            }
+        }
+    }
+
+    void HookRunner::addHook(const QString &name, const QString &command, int timeout, Flags flags) {
+        if (command.isEmpty())
+            return;
+
+        m_hooks.append({ name, command, timeout, flags, nullptr, nullptr, QElapsedTimer(), 0, false });
+    }
+
+    void HookRunner::setProcessEnvironment(const QProcessEnvironment &env) {
+        m_env = env;
+    }
+
+    bool HookRunner::isRunning() const {
+        // m_next goes past the end once finished() has been emitted
+        return m_started && m_next <= m_hooks.size();
+    }
+
+    void HookRunner::start() {
+        if (m_started)
+            return;
+        m_started = true;
+
+        QTimer::singleShot(0, this, SLOT(schedule()));
+    }
+
+    void HookRunner::schedule() {
+        while (m_next < m_hooks.size()) {
+            Hook &hook = m_hooks[m_next];
+
+            // sequential hooks wait for everything before them, and
+            // everything after them waits for them
+            if (m_running > 0 && (!(hook.flags & Parallel) || !(m_hooks[m_next - 1].flags & Parallel)))
+                break;
+
+            // a hook failing to start may get us back in here right away
+            ++m_next;
+            launch(hook);
+        }
+
+        if (!m_ready) {
+            bool blocked = false;
+            for (int i = 0; i < m_hooks.size() && !blocked; ++i)
+                blocked = !m_hooks[i].done && !(m_hooks[i].flags & NonBlocking);
+            if (!blocked) {
+                m_ready = true;
+                emit ready();
+            }
+        }
+
+        if (m_next == m_hooks.size() && m_running == 0) {
+            ++m_next;
+            emit finished();
+        }
+    }
+
+    void HookRunner::launch(Hook &hook) {
+        hook.process = new QProcess(this);
+        hook.process->setProcessEnvironment(m_env);
+        connect(hook.process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(hookFinished()));
+        connect(hook.process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(hookFinished()));
+
+        hook.timer = new QTimer(this);
+        hook.timer->setSingleShot(true);
+        connect(hook.timer, SIGNAL(timeout()), this, SLOT(hookTimedOut()));
+
+        qCDebug(SDDM_DISPLAY) << "Running hook" << hook.name << ":" << hook.command;
+        ++m_running;
+        hook.elapsed.start();
+        hook.started = LoginTrace::now();
+        hook.timer->start(hook.timeout);
+        hook.process->start(hook.command);
+    }
+
+    int HookRunner::indexOf(QObject *object) const {
+        for (int i = 0; i < m_hooks.size(); ++i) {
+            if (m_hooks[i].process == object || m_hooks[i].timer == object)
+                return i;
+        }
+        return -1;
+    }
+
+    void HookRunner::hookFinished() {
+        int index = indexOf(sender());
+        if (index < 0)
+            return;
+
+        Hook &hook = m_hooks[index];
+
+        // error() is also emitted for a crash, right before finished()
+        if (hook.done || (hook.process->state() != QProcess::NotRunning))
+            return;
+        hook.done = true;
+        StartupTrace::addSpan(QStringLiteral("hook %1").arg(hook.name), QStringLiteral("sddm"), hook.started);
+
+        hook.timer->stop();
+        hook.timer->deleteLater();
+        hook.timer = nullptr;
+
+        if (hook.process->error() == QProcess::FailedToStart)
+            qCWarning(SDDM_DISPLAY) << "Hook" << hook.name << "failed to start:" << hook.process->errorString();
+        else if (hook.process->exitStatus() != QProcess::NormalExit)
+            qCWarning(SDDM_DISPLAY) << "Hook" << hook.name << "crashed or was killed after" << hook.elapsed.elapsed() << "ms";
+        else
+            qCDebug(SDDM_DISPLAY) << "Hook" << hook.name << "exited with" << hook.process->exitCode()
+                     << "after" << hook.elapsed.elapsed() << "ms";
+
+        hook.process->deleteLater();
+        hook.process = nullptr;
+
+        --m_running;
+        schedule();
+    }
+
+    void HookRunner::hookTimedOut() {
+        int index = indexOf(sender());
+        if (index < 0 || !m_hooks[index].process)
+            return;
+
+        // finished() follows and moves on to the next hook
+        qCWarning(SDDM_DISPLAY) << "Hook" << m_hooks[index].name << "timed out after" << m_hooks[index].timeout << "ms, killing it";
+        m_hooks[index].process->kill();
+    }
+}
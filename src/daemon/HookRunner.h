@@ -0,0 +1,119 @@
+/*
+ * Asynchronous runner for display setup and teardown scripts
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_HOOKRUNNER_H
+#define SDDM_HOOKRUNNER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QProcessEnvironment>
+#include <QtCore/QVector>
+
+class QProcess;
+class QTimer;
+
+namespace SDDM {
+    /**
+    * \brief
+    * Runs an ordered list of hook commands without blocking the event loop
+    *
+    * \section description
+    * Hooks run in the order they were added. A hook only starts once every
+    * hook before it has finished, unless it and the hooks right before it
+    * are all \ref Parallel, in which case they run at the same time.
+    *
+    * \ref ready is emitted as soon as every hook which isn't \ref NonBlocking
+    * has finished, so whatever waits for the hooks can overlap with the
+    * non-blocking ones. \ref finished follows once all of them are done.
+    *
+    * A hook still running after its timeout is killed. The duration and
+    * outcome of each hook are logged.
+    */
+    class HookRunner : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(HookRunner)
+    public:
+        enum Flag {
+            NoFlags     = 0x0,
+            Parallel    = 0x1, ///< may run at the same time as neighbouring parallel hooks
+            NonBlocking = 0x2  ///< \ref ready doesn't wait for it
+        };
+        Q_DECLARE_FLAGS(Flags, Flag)
+
+        explicit HookRunner(QObject *parent = nullptr);
+        ~HookRunner();
+
+        /**
+        * Adds a hook, empty commands are ignored
+        * @param name name used in the log
+        * @param command command line, as passed to QProcess::start
+        * @param timeout milliseconds after which it's killed
+        * @param flags how it's scheduled
+        */
+        void addHook(const QString &name, const QString &command, int timeout, Flags flags = NoFlags);
+
+        void setProcessEnvironment(const QProcessEnvironment &env);
+
+        bool isRunning() const;
+
+    public slots:
+        /**
+        * Starts running the hooks, \ref ready and \ref finished are emitted
+        * from the event loop even if there's nothing to run
+        */
+        void start();
+
+    signals:
+        void ready();
+        void finished();
+
+    private slots:
+        void hookFinished();
+        void hookTimedOut();
+        void schedule();
+
+    private:
+        struct Hook {
+            QString name;
+            QString command;
+            int timeout;
+            Flags flags;
+            QProcess *process;
+            QTimer *timer;
+            QElapsedTimer elapsed;
+            qint64 started;
+            bool done;
+        };
+
+        int indexOf(QObject *object) const;
+        void launch(Hook &hook);
+
+        QVector<Hook> m_hooks;
+        QProcessEnvironment m_env;
+        int m_next { 0 };
+        int m_running { 0 };
+        bool m_started { false };
+        bool m_ready { false };
+    };
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SDDM::HookRunner::Flags)
+
+#endif // SDDM_HOOKRUNNER_H
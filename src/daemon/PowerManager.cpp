@@ -21,92 +21,286 @@
 
 #include "Configuration.h"
 #include "DaemonApp.h"
+#include "LoggingCategories.h"
 #include "Messages.h"
 
 #include <QDBusConnectionInterface>
-#include <QDBusInterface>
-#include <QDBusReply>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDebug>
 #include <QProcess>
+#include <QTimer>
+
+// how long the capabilities are trusted without anything telling
+// that they changed
+const int CAPABILITIES_TTL = 60 * 1000;
 
 namespace SDDM {
     /************************************************/
-    /* POWER MANAGER BACKEND                        */
+    /* POWER ACTION                                 */
     /************************************************/
-    class PowerManagerBackend {
-    public:
-        PowerManagerBackend() {
-        }
+    PowerAction::PowerAction(Capability action, int timeout, QObject *parent)
+        : QObject(parent)
+        , m_action(action) {
+        QTimer::singleShot(timeout, this, SLOT(timedOut()));
+    }
+
+    Capability PowerAction::action() const {
+        return m_action;
+    }
+
+    PowerActionResult PowerAction::result() const {
+        return m_result;
+    }
+
+    void PowerAction::finish(PowerActionResult result) {
+        if (m_finished)
+            return;
+        m_finished = true;
+        m_result = result;
+
+        // whoever started it may not have connected yet
+        QMetaObject::invokeMethod(this, "done", Qt::QueuedConnection);
+    }
+
+    void PowerAction::done() {
+        emit finished();
+        deleteLater();
+    }
 
-        virtual ~PowerManagerBackend() {
+    void PowerAction::timedOut() {
+        qCWarning(SDDM_POWER) << "Power action" << m_action << "didn't finish in time";
+        finish(PowerActionResult::Failed);
+    }
+
+    void PowerAction::callFinished(QDBusPendingCallWatcher *call) {
+        const QDBusMessage reply = call->reply();
+        if (reply.type() != QDBusMessage::ErrorMessage) {
+            finish(PowerActionResult::Succeeded);
+            return;
         }
 
-        virtual Capabilities capabilities() const = 0;
+        qCWarning(SDDM_POWER) << "Power action" << m_action << "failed:" << reply.errorName() << reply.errorMessage();
 
-        virtual void powerOff() const = 0;
-        virtual void reboot() const = 0;
-        virtual void suspend() const = 0;
-        virtual void hibernate() const = 0;
-        virtual void hybridSleep() const = 0;
-    };
+        // refused because something holds a block inhibitor, like logind's
+        // BlockedByInhibitorLock. Being denied the action as such is just
+        // a failure, whatever the reason.
+        const QString error = reply.errorName();
+        if (error.contains(QLatin1String("Inhibit")))
+            finish(PowerActionResult::Inhibited);
+        else
+            finish(PowerActionResult::Failed);
+    }
 
-    /**********************************************/
-    /* UPOWER BACKEND                             */
-    /**********************************************/
+    void PowerAction::processFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+        if (exitStatus == QProcess::NormalExit && exitCode == 0)
+            finish(PowerActionResult::Succeeded);
+        else
+            finish(PowerActionResult::Failed);
+    }
 
-const QString UPOWER_PATH = QStringLiteral("/org/freedesktop/UPower");
-const QString UPOWER_SERVICE = QStringLiteral("org.freedesktop.UPower");
-const QString UPOWER_OBJECT = QStringLiteral("org.freedesktop.UPower");
+    void PowerAction::processError(QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qCWarning(SDDM_POWER) << "Failed to run the command of power action" << m_action;
+            finish(PowerActionResult::Failed);
+        }
+    }
 
-    class UPowerBackend : public PowerManagerBackend {
+    /************************************************/
+    /* POWER MANAGER BACKEND                        */
+    /************************************************/
+
+const QString DBUS_PROPERTIES = QStringLiteral("org.freedesktop.DBus.Properties");
+
+    class PowerManagerBackend : public QObject {
+        Q_OBJECT
     public:
-        UPowerBackend(const QString & service, const QString & path, const QString & interface) {
-            m_interface = new QDBusInterface(service, path, interface, QDBusConnection::systemBus());
+        PowerManagerBackend(const QString & service, const QString & path, const QString & interface)
+            : m_service(service)
+            , m_path(path)
+            , m_interface(interface) {
+            // whatever changed might change what can be done as well
+            QDBusConnection::systemBus().connect(service, path, DBUS_PROPERTIES, QStringLiteral("PropertiesChanged"),
+                                                 this, SLOT(refresh()));
         }
 
-        ~UPowerBackend() {
-            delete m_interface;
+        /**
+        * What could be done as of the last refresh
+        */
+        Capabilities capabilities() const {
+            return m_capabilities;
         }
 
-        Capabilities capabilities() const {
-            Capabilities caps = Capability::PowerOff | Capability::Reboot;
+        /**
+        * Whether a refresh finished yet, before that nothing is known
+        */
+        bool isRefreshed() const {
+            return m_refreshed;
+        }
+
+        /**
+        * Starts \a action, which finishes it once the outcome is known
+        */
+        virtual void start(PowerAction *action) = 0;
+
+    public slots:
+        /**
+        * Asks the service again what can be done, without waiting for
+        * the answers, \ref capabilitiesChanged tells if it changed
+        */
+        void refresh() {
+            // one at a time, the answers of an older round would be stale
+            if (m_pending > 0) {
+                m_refreshAgain = true;
+                return;
+            }
+
+            m_next = fixedCapabilities();
+            const QList<QPair<QString, Capability>> queries = capabilityQueries();
+            m_pending = queries.size();
+            if (m_pending == 0) {
+                update();
+                return;
+            }
+
+            for (const auto &query : queries) {
+                QDBusMessage message = QDBusMessage::createMethodCall(m_service, m_path, m_interface, query.first);
+                QDBusPendingCallWatcher *call = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+                call->setProperty("capability", int(query.second));
+                connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)), this, SLOT(queryFinished(QDBusPendingCallWatcher*)));
+            }
+        }
 
-            QDBusReply<bool> reply;
+    signals:
+        void capabilitiesChanged();
+        void refreshed();
 
-            // suspend
-            reply = m_interface->call(QStringLiteral("SuspendAllowed"));
-            if (reply.isValid() && reply.value())
-                caps |= Capability::Suspend;
+    protected:
+        /**
+        * What can always be done
+        */
+        virtual Capabilities fixedCapabilities() const {
+            return Capability::None;
+        }
+
+        /**
+        * Methods to call, and the capability each of them asks about
+        */
+        virtual QList<QPair<QString, Capability>> capabilityQueries() const = 0;
+
+        /**
+        * Calls \a method of the service for \a action without waiting
+        */
+        void call(PowerAction *action, const QString &method, const QVariantList &arguments = QVariantList()) {
+            QDBusMessage message = QDBusMessage::createMethodCall(m_service, m_path, m_interface, method);
+            message.setArguments(arguments);
+
+            // goes away with the action if that times out first
+            QDBusPendingCallWatcher *call = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), action);
+            connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)), action, SLOT(callFinished(QDBusPendingCallWatcher*)));
+        }
+
+    private slots:
+        void queryFinished(QDBusPendingCallWatcher *call) {
+            call->deleteLater();
 
-            // hibernate
-            reply = m_interface->call(QStringLiteral("HibernateAllowed"));
-            if (reply.isValid() && reply.value())
-                caps |= Capability::Hibernate;
+            // logind and ConsoleKit2 answer "yes", UPower true
+            const QDBusMessage reply = call->reply();
+            if (reply.type() == QDBusMessage::ReplyMessage && !reply.arguments().isEmpty()) {
+                const QVariant answer = reply.arguments().first();
+                if (answer.type() == QVariant::Bool ? answer.toBool() : answer.toString() == QLatin1String("yes"))
+                    m_next |= Capability(call->property("capability").toInt());
+            }
 
-            // return capabilities
-            return caps;
+            if (--m_pending == 0)
+                update();
         }
 
-        void powerOff() const {
-            QProcess::execute(mainConfig.HaltCommand.get());
+    private:
+        void update() {
+            const bool changed = m_next != m_capabilities;
+            m_capabilities = m_next;
+            m_refreshed = true;
+            if (changed)
+                emit capabilitiesChanged();
+            emit refreshed();
+
+            if (m_refreshAgain) {
+                m_refreshAgain = false;
+                refresh();
+            }
         }
 
-        void reboot() const {
-            QProcess::execute(mainConfig.RebootCommand.get());
+        QString m_service;
+        QString m_path;
+        QString m_interface;
+        Capabilities m_capabilities { Capability::None };
+        Capabilities m_next { Capability::None };
+        int m_pending { 0 };
+        bool m_refreshAgain { false };
+        bool m_refreshed { false };
+    };
+
+    /**********************************************/
+    /* UPOWER BACKEND                             */
+    /**********************************************/
+
+const QString UPOWER_PATH = QStringLiteral("/org/freedesktop/UPower");
+const QString UPOWER_SERVICE = QStringLiteral("org.freedesktop.UPower");
+const QString UPOWER_OBJECT = QStringLiteral("org.freedesktop.UPower");
+
+    class UPowerBackend : public PowerManagerBackend {
+    public:
+        UPowerBackend(const QString & service, const QString & path, const QString & interface)
+            : PowerManagerBackend(service, path, interface) {
+            // older versions only tell that something changed
+            QDBusConnection::systemBus().connect(service, path, interface, QStringLiteral("Changed"),
+                                                 this, SLOT(refresh()));
         }
 
-        void suspend() const {
-            m_interface->call(QStringLiteral("Suspend"));
+        void start(PowerAction *action) {
+            switch (action->action()) {
+                case Capability::PowerOff:
+                    execute(action, mainConfig.HaltCommand.get());
+                    break;
+                case Capability::Reboot:
+                    execute(action, mainConfig.RebootCommand.get());
+                    break;
+                case Capability::Suspend:
+                    call(action, QStringLiteral("Suspend"));
+                    break;
+                case Capability::Hibernate:
+                    call(action, QStringLiteral("Hibernate"));
+                    break;
+                default:
+                    action->finish(PowerActionResult::Failed);
+                    break;
+            }
         }
 
-        void hibernate() const {
-            m_interface->call(QStringLiteral("Hibernate"));
+    protected:
+        Capabilities fixedCapabilities() const {
+            return Capability::PowerOff | Capability::Reboot;
         }
 
-        void hybridSleep() const {
+        QList<QPair<QString, Capability>> capabilityQueries() const {
+            return {
+                { QStringLiteral("SuspendAllowed"), Capability::Suspend },
+                { QStringLiteral("HibernateAllowed"), Capability::Hibernate }
+            };
         }
 
     private:
-        QDBusInterface *m_interface { nullptr };
+        void execute(PowerAction *action, const QString &command) {
+            // not parented to the action, a shutdown is better left to
+            // finish even if it takes longer than the action may
+            QProcess *process = new QProcess(daemonApp);
+            connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), action, SLOT(processFinished(int,QProcess::ExitStatus)));
+            connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), process, SLOT(deleteLater()));
+            connect(process, SIGNAL(error(QProcess::ProcessError)), action, SLOT(processError(QProcess::ProcessError)));
+            connect(process, SIGNAL(error(QProcess::ProcessError)), process, SLOT(deleteLater()));
+            process->start(command);
+        }
     };
 
     /**********************************************/
@@ -123,71 +317,46 @@ const QString CK2_OBJECT = QStringLiteral("org.freedesktop.ConsoleKit.Manager");
 
     class SeatManagerBackend : public PowerManagerBackend {
     public:
-        SeatManagerBackend(const QString & service, const QString & path, const QString & interface) {
-            m_interface = new QDBusInterface(service, path, interface, QDBusConnection::systemBus());
-        }
-
-        ~SeatManagerBackend() {
-            delete m_interface;
-        }
-
-        Capabilities capabilities() const {
-            Capabilities caps = Capability::None;
-
-            QDBusReply<QString> reply;
-
-            // power off
-            reply = m_interface->call(QStringLiteral("CanPowerOff"));
-            if (reply.isValid() && (reply.value() == QLatin1String("yes")))
-                caps |= Capability::PowerOff;
-
-            // reboot
-            reply = m_interface->call(QStringLiteral("CanReboot"));
-            if (reply.isValid() && (reply.value() == QLatin1String("yes")))
-                caps |= Capability::Reboot;
-
-            // suspend
-            reply = m_interface->call(QStringLiteral("CanSuspend"));
-            if (reply.isValid() && (reply.value() == QLatin1String("yes")))
-                caps |= Capability::Suspend;
-
-            // hibernate
-            reply = m_interface->call(QStringLiteral("CanHibernate"));
-            if (reply.isValid() && (reply.value() == QLatin1String("yes")))
-                caps |= Capability::Hibernate;
-
-            // hybrid sleep
-            reply = m_interface->call(QStringLiteral("CanHybridSleep"));
-            if (reply.isValid() && (reply.value() == QLatin1String("yes")))
-                caps |= Capability::HybridSleep;
-
-            // return capabilities
-            return caps;
-        }
-
-        void powerOff() const {
-            m_interface->call(QStringLiteral("PowerOff"), true);
-        }
-
-        void reboot() const {
-            if (!daemonApp->testing())
-                m_interface->call(QStringLiteral("Reboot"), true);
+        SeatManagerBackend(const QString & service, const QString & path, const QString & interface)
+            : PowerManagerBackend(service, path, interface) {
         }
 
-        void suspend() const {
-            m_interface->call(QStringLiteral("Suspend"), true);
-        }
-
-        void hibernate() const {
-            m_interface->call(QStringLiteral("Hibernate"), true);
+        void start(PowerAction *action) {
+            // interactive, the service may ask for authorization
+            const QVariantList interactive { true };
+
+            switch (action->action()) {
+                case Capability::PowerOff:
+                    call(action, QStringLiteral("PowerOff"), interactive);
+                    break;
+                case Capability::Reboot:
+                    call(action, QStringLiteral("Reboot"), interactive);
+                    break;
+                case Capability::Suspend:
+                    call(action, QStringLiteral("Suspend"), interactive);
+                    break;
+                case Capability::Hibernate:
+                    call(action, QStringLiteral("Hibernate"), interactive);
+                    break;
+                case Capability::HybridSleep:
+                    call(action, QStringLiteral("HybridSleep"), interactive);
+                    break;
+                default:
+                    action->finish(PowerActionResult::Failed);
+                    break;
+            }
         }
 
-        void hybridSleep() const {
-            m_interface->call(QStringLiteral("HybridSleep"), true);
+    protected:
+        QList<QPair<QString, Capability>> capabilityQueries() const {
+            return {
+                { QStringLiteral("CanPowerOff"), Capability::PowerOff },
+                { QStringLiteral("CanReboot"), Capability::Reboot },
+                { QStringLiteral("CanSuspend"), Capability::Suspend },
+                { QStringLiteral("CanHibernate"), Capability::Hibernate },
+                { QStringLiteral("CanHybridSleep"), Capability::HybridSleep }
+            };
         }
-
-    private:
-        QDBusInterface *m_interface { nullptr };
     };
 
     /**********************************************/
@@ -207,6 +376,14 @@ const QString CK2_OBJECT = QStringLiteral("org.freedesktop.ConsoleKit.Manager");
         // check if upower interface exists
         if (interface->isServiceRegistered(UPOWER_SERVICE))
             m_backends << new UPowerBackend(UPOWER_SERVICE, UPOWER_PATH, UPOWER_OBJECT);
+
+        for (PowerManagerBackend *backend: m_backends) {
+            connect(backend, SIGNAL(capabilitiesChanged()), this, SLOT(backendChanged()));
+            connect(backend, SIGNAL(refreshed()), this, SLOT(backendRefreshed()));
+        }
+
+        // ready by the time the first greeter asks
+        refresh();
     }
 
     PowerManager::~PowerManager() {
@@ -214,72 +391,93 @@ const QString CK2_OBJECT = QStringLiteral("org.freedesktop.ConsoleKit.Manager");
             delete m_backends.takeFirst();
     }
 
-    Capabilities PowerManager::capabilities() const {
+    Capabilities PowerManager::capabilities() {
+        // answer right away, whatever changed since shows up later
+        if (m_age.hasExpired(CAPABILITIES_TTL))
+            QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+
+        return m_capabilities;
+    }
+
+    void PowerManager::refresh() {
+        m_age.start();
+
+        for (PowerManagerBackend *backend: m_backends)
+            backend->refresh();
+    }
+
+    void PowerManager::backendChanged() {
         Capabilities caps = Capability::None;
 
         for (PowerManagerBackend *backend: m_backends)
             caps |= backend->capabilities();
 
-        return caps;
-    }
-
-    void PowerManager::powerOff() const {
-        if (daemonApp->testing())
+        if (caps == m_capabilities)
             return;
 
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::PowerOff) {
-                backend->powerOff();
-                break;
-            }
-        }
+        m_capabilities = caps;
+        emit capabilitiesChanged(m_capabilities);
     }
 
-    void PowerManager::reboot() const {
-        if (daemonApp->testing())
-            return;
-
+    void PowerManager::backendRefreshed() {
         for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Reboot) {
-                backend->reboot();
-                break;
-            }
+            if (!backend->isRefreshed())
+                return;
+        }
+
+        // the actions asked for before anything was known
+        const QList<QPointer<PowerAction>> queued = m_queued;
+        m_queued.clear();
+        for (PowerAction *job : queued) {
+            if (job)
+                dispatch(job);
         }
     }
 
-    void PowerManager::suspend() const {
-        if (daemonApp->testing())
-            return;
+    PowerAction *PowerManager::start(Capability action) {
+        PowerAction *job = new PowerAction(action, actionTimeout(action), this);
 
+        // nothing happens when testing, as far as anyone can tell it worked
+        if (daemonApp->testing()) {
+            job->finish(PowerActionResult::Succeeded);
+            return job;
+        }
+
+        // right after startup, wait for the services to tell what they
+        // can do, the action's timeout still applies
         for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Suspend) {
-                backend->suspend();
-                break;
+            if (!backend->isRefreshed()) {
+                m_queued << job;
+                return job;
             }
         }
-    }
 
-    void PowerManager::hibernate() const {
-        if (daemonApp->testing())
-            return;
+        dispatch(job);
+        return job;
+    }
 
+    void PowerManager::dispatch(PowerAction *job) {
         for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Hibernate) {
-                backend->hibernate();
-                break;
+            if (backend->capabilities() & job->action()) {
+                backend->start(job);
+                return;
             }
         }
-    }
 
-    void PowerManager::hybridSleep() const {
-        if (daemonApp->testing())
-            return;
+        qCWarning(SDDM_POWER) << "No service can do power action" << job->action();
+        job->finish(PowerActionResult::Failed);
+    }
 
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::HybridSleep) {
-                backend->hybridSleep();
-                break;
-            }
+    int PowerManager::actionTimeout(Capability action) {
+        switch (action) {
+            // shutdown inhibitors may delay these
+            case Capability::PowerOff:
+            case Capability::Reboot:
+                return mainConfig.ShutdownTimeout.get() * 1000;
+            default:
+                return mainConfig.SleepTimeout.get() * 1000;
         }
     }
 }
+
+#include "PowerManager.moc"
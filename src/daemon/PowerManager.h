@@ -20,14 +20,64 @@
 #ifndef SDDM_POWERMANAGER_H
 #define SDDM_POWERMANAGER_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QPointer>
+#include <QProcess>
 #include <QVector>
 
 #include "Messages.h"
 
+class QDBusPendingCallWatcher;
+
 namespace SDDM {
     class PowerManagerBackend;
 
+    /**
+    * A power action on its way, finished once the service or command
+    * doing it answered, or when it took too long
+    */
+    class PowerAction : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(PowerAction)
+    public:
+        PowerAction(Capability action, int timeout, QObject *parent = 0);
+
+        Capability action() const;
+        PowerActionResult result() const;
+
+        /**
+        * Sets the result, \ref finished follows from the event loop,
+        * only the first result counts
+        */
+        void finish(PowerActionResult result);
+
+    signals:
+        void finished();
+
+    private slots:
+        void done();
+        void timedOut();
+        void callFinished(QDBusPendingCallWatcher *call);
+        void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+        void processError(QProcess::ProcessError error);
+
+    private:
+        Capability m_action { Capability::None };
+        PowerActionResult m_result { PowerActionResult::Failed };
+        bool m_finished { false };
+    };
+
+    /**
+    * \brief
+    * Power actions available through the system's services
+    *
+    * \section description
+    * The capabilities are cached, and refreshed in the background when a
+    * service tells its properties changed, or when they're asked for and
+    * haven't been refreshed for a minute. \ref capabilitiesChanged is
+    * emitted when they turn out to be different.
+    */
     class PowerManager : public QObject {
         Q_OBJECT
         Q_DISABLE_COPY(PowerManager)
@@ -36,16 +86,35 @@ namespace SDDM {
         ~PowerManager();
 
     public slots:
-        Capabilities capabilities() const;
+        /**
+        * The capabilities as of the last refresh, never waits
+        */
+        Capabilities capabilities();
+
+        void refresh();
 
-        void powerOff() const;
-        void reboot() const;
-        void suspend() const;
-        void hibernate() const;
-        void hybridSleep() const;
+        /**
+        * Starts \a action without waiting for it, the action is deleted
+        * once it's finished. Until the first refresh is through it's held
+        * back, nothing would be known to be possible yet.
+        */
+        PowerAction *start(Capability action);
+
+    signals:
+        void capabilitiesChanged(Capabilities capabilities);
+
+    private slots:
+        void backendChanged();
+        void backendRefreshed();
 
     private:
+        static int actionTimeout(Capability action);
+        void dispatch(PowerAction *job);
+
         QVector<PowerManagerBackend *> m_backends;
+        Capabilities m_capabilities { Capability::None };
+        QElapsedTimer m_age;
+        QList<QPointer<PowerAction>> m_queued;
     };
 }
 
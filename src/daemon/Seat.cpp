@@ -23,13 +23,20 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "Display.h"
+#include "HelperPool.h"
+#include "LoggingCategories.h"
+#include "VirtualTerminal.h"
 #include "XorgDisplayServer.h"
 
 #include <QDebug>
 #include <QFile>
+#include <QTimer>
 
 #include <functional>
 
+// a display server that fails this many times in a row won't do any better
+#define MAX_DISPLAY_FAILURES 3
+
 namespace SDDM {
     int findUnused(int minimum, std::function<bool(const int)> used) {
         // initialize with minimum
@@ -43,7 +50,18 @@ namespace SDDM {
         return number;
     }
 
-    Seat::Seat(const QString &name, QObject *parent) : QObject(parent), m_name(name) {
+    Seat::Seat(const QString &name, bool hasVirtualTerminals, QObject *parent) : QObject(parent),
+        m_name(name), m_hasVirtualTerminals(hasVirtualTerminals) {
+        // keep some helpers ready for the next login, sized along with
+        // the first display
+        m_helperPool = new HelperPool(this);
+
+        // lowered if they turn out to need more memory than allowed
+        // and they're only switched to through the virtual terminals
+        m_standbyLimit = hasVirtualTerminals() ? mainConfig.StandbyDisplays.get() : 0;
+        if (m_standbyLimit > 0)
+            connect(VirtualTerminal::Switcher::instance(), SIGNAL(jumped(int,bool)), this, SLOT(terminalJumped(int,bool)));
+
         createDisplay();
     }
 
@@ -51,28 +69,58 @@ namespace SDDM {
         return m_name;
     }
 
+    HelperPool *Seat::helperPool() const {
+        return m_helperPool;
+    }
+
+    bool Seat::hasVirtualTerminals() const {
+        return m_hasVirtualTerminals;
+    }
+
     void Seat::createDisplay(int terminalId) {
         //reload config if needed
         mainConfig.load();
-        
+
+        m_helperPool->setIdleTimeout(mainConfig.HelperIdleTimeout.get());
+        m_helperPool->setSize(mainConfig.HelperPoolSize.get());
+
+        // show the greeter that's already waiting, if there's one
         if (terminalId == -1) {
-                // find unused terminal
-            terminalId = findUnused(mainConfig.X11.MinimumVT.get(), [&](const int number) {
-                return m_terminalIds.contains(number);
-            });
+            for (Display *display : m_standby) {
+                if (!display->isStarted())
+                    continue;
+
+                qCDebug(SDDM_SEAT) << "Activating standby display on vt" << display->terminalId();
+                m_standby.removeAll(display);
+                m_displays << display;
+
+                // and get another one ready once we're there, it'd
+                // take the screen back to where we're coming from
+                m_activatingVt = display->terminalId();
+                display->activate();
+                return;
+            }
         }
 
-        // mark terminal as used
-        m_terminalIds << terminalId;
+        // there's no switching between displays without virtual terminals
+        if (!hasVirtualTerminals() && !m_displays.isEmpty()) {
+            qCWarning(SDDM_SEAT) << "Seat" << m_name << "has no virtual terminals, it can't show another display";
+            return;
+        }
+
+        // find unused terminal, and mark it as used
+        terminalId = reserveTerminal(terminalId == -1 ? mainConfig.X11.MinimumVT.get() : terminalId);
 
         // log message
-        qDebug() << "Adding new display" << "on vt" << terminalId << "...";
+        qCDebug(SDDM_SEAT) << "Adding new display" << "on vt" << terminalId << "...";
 
         // create a new display
         Display *display = new Display(terminalId, this);
 
         // restart display on stop
+        connect(display, SIGNAL(started()), this, SLOT(displayStarted()));
         connect(display, SIGNAL(stopped()), this, SLOT(displayStopped()));
+        connect(display, SIGNAL(failed()), this, SLOT(displayFailed()));
 
         // add display to the list
         m_displays << display;
@@ -82,14 +130,15 @@ namespace SDDM {
     }
 
     void Seat::removeDisplay(Display* display) {
-        qDebug() << "Removing display" << display->displayId() << "...";
+        qCDebug(SDDM_SEAT) << "Removing display" << display->displayId() << "...";
 
 
         // remove display from list
         m_displays.removeAll(display);
+        m_standby.removeAll(display);
 
         // mark display and terminal ids as unused
-        m_terminalIds.removeAll(display->terminalId());
+        releaseTerminal(display->terminalId());
 
         // stop the display
         display->blockSignals(true);
@@ -100,9 +149,102 @@ namespace SDDM {
         display->deleteLater();
     }
 
+    void Seat::displayStarted() {
+        Display *display = qobject_cast<Display *>(sender());
+
+        if (!display->isStandby()) {
+            m_failures = 0;
+
+            // something is on screen now, the standby can come up behind it
+            QTimer::singleShot(0, this, SLOT(replenishStandby()));
+        }
+    }
+
+    void Seat::standbyGreeterConnected() {
+        Display *display = qobject_cast<Display *>(sender());
+        if (!m_standby.contains(display))
+            return;
+
+        // the greeter process is up with Qt loaded, its theme comes
+        // from the handshake and adds only a little more
+        const qint64 budget = qint64(mainConfig.StandbyMemoryLimit.get()) * 1024 * 1024;
+        if (budget <= 0)
+            return;
+
+        qint64 used = 0;
+        for (Display *standby : m_standby)
+            used += standby->residentMemory();
+        if (used <= budget)
+            return;
+
+        qCWarning(SDDM_SEAT) << "Standby displays use" << used / 1024 / 1024 << "MiB, more than the"
+                   << budget / 1024 / 1024 << "MiB allowed, keeping one less";
+        m_standbyLimit = m_standby.size() - 1;
+        removeDisplay(display);
+    }
+
+    void Seat::terminalJumped(int vt, bool success) {
+        Q_UNUSED(success)
+
+        if (vt != m_activatingVt)
+            return;
+
+        m_activatingVt = -1;
+        replenishStandby();
+    }
+
+    void Seat::replenishStandby() {
+        // a standby starting now would go back to the VT we're leaving
+        if (m_activatingVt != -1)
+            return;
+
+        while (m_standby.size() < m_standbyLimit) {
+            int terminalId = reserveTerminal(mainConfig.X11.MinimumVT.get());
+
+            qCDebug(SDDM_SEAT) << "Adding standby display on vt" << terminalId << "...";
+
+            Display *display = new Display(terminalId, this);
+            display->setStandby(true);
+            connect(display, SIGNAL(started()), this, SLOT(displayStarted()));
+            connect(display, SIGNAL(stopped()), this, SLOT(displayStopped()));
+            connect(display, SIGNAL(greeterConnected()), this, SLOT(standbyGreeterConnected()));
+            m_standby << display;
+
+            display->start();
+        }
+    }
+
+    int Seat::reserveTerminal(int minimum) {
+        // VTs are shared by everything on the seat that has them
+        if (hasVirtualTerminals())
+            return VirtualTerminal::Allocator::instance()->reserve(minimum, QStringLiteral("display"));
+
+        // elsewhere they're just ids
+        int terminalId = findUnused(minimum, [&](const int number) {
+            return m_terminalIds.contains(number);
+        });
+        m_terminalIds << terminalId;
+        return terminalId;
+    }
+
+    void Seat::releaseTerminal(int terminalId) {
+        if (hasVirtualTerminals())
+            VirtualTerminal::Allocator::instance()->release(terminalId);
+        else
+            m_terminalIds.removeAll(terminalId);
+    }
+
     void Seat::displayStopped() {
         Display *display = qobject_cast<Display *>(sender());
 
+        // not replacing it, it'd just fail again
+        if (m_standby.contains(display)) {
+            qCWarning(SDDM_SEAT) << "Standby display on vt" << display->terminalId() << "stopped";
+            m_standbyLimit = qMin(m_standbyLimit, m_standby.size() - 1);
+            removeDisplay(display);
+            return;
+        }
+
         // remove display
         removeDisplay(display);
 
@@ -110,4 +252,18 @@ namespace SDDM {
         if (m_displays.isEmpty())
             createDisplay();
     }
+
+    void Seat::displayFailed() {
+        Display *display = qobject_cast<Display *>(sender());
+        removeDisplay(display);
+
+        // try again a bit later, the device may just not be ready yet
+        if (++m_failures < MAX_DISPLAY_FAILURES) {
+            qCWarning(SDDM_SEAT) << "Retrying the display of seat" << m_name << "in" << m_failures << "seconds";
+            QTimer::singleShot(m_failures * 1000, this, SLOT(createDisplay()));
+            return;
+        }
+
+        qCCritical(SDDM_SEAT) << "Display server of seat" << m_name << "failed" << m_failures << "times, giving up on it";
+    }
 }
@@ -25,26 +25,51 @@
 
 namespace SDDM {
     class Display;
+    class HelperPool;
 
     class Seat : public QObject {
         Q_OBJECT
         Q_DISABLE_COPY(Seat)
     public:
-        explicit Seat(const QString &name, QObject *parent = 0);
+        Seat(const QString &name, bool hasVirtualTerminals, QObject *parent = 0);
 
         const QString &name() const;
 
+        HelperPool *helperPool() const;
+
+        /**
+        * Whether the seat is attached to the virtual terminals, logind's
+        * CanTTY. The displays of any other seat have their devices to
+        * themselves.
+        */
+        bool hasVirtualTerminals() const;
+
     public slots:
         void createDisplay(int terminalId = -1);
         void removeDisplay(SDDM::Display* display);
 
     private slots:
+        void displayStarted();
         void displayStopped();
+        void displayFailed();
+        void standbyGreeterConnected();
+        void terminalJumped(int vt, bool success);
+        void replenishStandby();
 
     private:
+        int reserveTerminal(int minimum);
+        void releaseTerminal(int terminalId);
+
         QString m_name;
+        bool m_hasVirtualTerminals { false };
+
+        HelperPool *m_helperPool { nullptr };
 
         QVector<Display *> m_displays;
+        QVector<Display *> m_standby;
+        int m_standbyLimit { 0 };
+        int m_activatingVt { -1 };
+        int m_failures { 0 };
         QVector<int> m_terminalIds;
     };
 }
@@ -19,15 +19,53 @@
 
 #include "SeatManager.h"
 
+#include "Configuration.h"
+#include "DaemonApp.h"
+#include "LoggingCategories.h"
 #include "Seat.h"
+#include "SeatWatcher.h"
+#include "StartupTrace.h"
+
+#include <QDBusConnection>
+#include <QDebug>
 
 namespace SDDM {
     SeatManager::SeatManager(QObject *parent) : QObject(parent) {
     }
 
-    void SeatManager::createSeat(const QString &name) {
+    void SeatManager::initialize() {
+        // the displays of each seat start without waiting for the others
+        if (!daemonApp->testing()) {
+            m_watcher = new SeatWatcher(QDBusConnection::systemBus(), this);
+            connect(m_watcher, SIGNAL(seatAdded(QString,bool)), this, SLOT(createSeat(QString,bool)));
+            connect(m_watcher, SIGNAL(seatRemoved(QString)), this, SLOT(removeSeat(QString)));
+            connect(m_watcher, SIGNAL(listFailed()), this, SLOT(createConfiguredSeats()));
+            if (m_watcher->start())
+                return;
+
+            delete m_watcher;
+            m_watcher = nullptr;
+            qCWarning(SDDM_SEAT) << "Not connected to the system bus, using the configured seats";
+        }
+
+        createConfiguredSeats();
+    }
+
+    void SeatManager::createConfiguredSeats() {
+        // nothing to ask, seat0 is the one with the virtual terminals
+        for (const QString &name : mainConfig.Seats.get())
+            createSeat(name, name == QLatin1String("seat0"));
+    }
+
+    void SeatManager::createSeat(const QString &name, bool hasVirtualTerminals) {
+        // check if seat exists
+        if (m_seats.contains(name))
+            return;
+
+        StartupTrace::Span span(QStringLiteral("SeatManager::createSeat %1").arg(name));
+
         // create a seat
-        Seat *seat = new Seat(name, this);
+        Seat *seat = new Seat(name, hasVirtualTerminals, this);
 
         // add to the list
         m_seats.insert(name, seat);
@@ -25,6 +25,7 @@
 
 namespace SDDM {
     class Seat;
+    class SeatWatcher;
 
     class SeatManager : public QObject {
         Q_OBJECT
@@ -32,18 +33,29 @@ namespace SDDM {
     public:
         explicit SeatManager(QObject *parent = 0);
 
+        /**
+        * Creates a seat for each seat logind knows can show graphics,
+        * and follows them as they come and go. Without logind, or if it
+        * can't list them, the seats are taken from the configuration.
+        */
+        void initialize();
+
     public slots:
-        void createSeat(const QString &name);
+        void createSeat(const QString &name, bool hasVirtualTerminals);
         void removeSeat(const QString &name);
 
         void switchToGreeter(const QString &seat);
 
+    private slots:
+        void createConfiguredSeats();
+
     signals:
         void seatCreated(const QString &name);
         void seatRemoved(const QString &name);
 
     private:
         QHash<QString, Seat *> m_seats;
+        SeatWatcher *m_watcher { nullptr };
     };
 }
 
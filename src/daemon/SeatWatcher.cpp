@@ -0,0 +1,196 @@
+/*
+ * Seat enumeration through logind
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SeatWatcher.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+
+namespace SDDM {
+    static const QString LOGIN1_SERVICE = QStringLiteral("org.freedesktop.login1");
+    static const QString LOGIN1_PATH = QStringLiteral("/org/freedesktop/login1");
+    static const QString LOGIN1_MANAGER = QStringLiteral("org.freedesktop.login1.Manager");
+    static const QString LOGIN1_SEAT = QStringLiteral("org.freedesktop.login1.Seat");
+    static const QString PROPERTIES = QStringLiteral("org.freedesktop.DBus.Properties");
+    static const QString CAN_GRAPHICAL = QStringLiteral("CanGraphical");
+    static const QString CAN_TTY = QStringLiteral("CanTTY");
+
+    QDBusArgument &operator<<(QDBusArgument &argument, const NamedSeatPath &seat) {
+        argument.beginStructure();
+        argument << seat.name << seat.path;
+        argument.endStructure();
+        return argument;
+    }
+
+    const QDBusArgument &operator>>(const QDBusArgument &argument, NamedSeatPath &seat) {
+        argument.beginStructure();
+        argument >> seat.name >> seat.path;
+        argument.endStructure();
+        return argument;
+    }
+
+    SeatWatcher::SeatWatcher(const QDBusConnection &bus, QObject *parent)
+        : QObject(parent)
+        , m_bus(bus) {
+        qDBusRegisterMetaType<NamedSeatPath>();
+        qDBusRegisterMetaType<NamedSeatPathList>();
+    }
+
+    bool SeatWatcher::start() {
+        // whether logind is there is up to the list call, asking first
+        // would block, and miss it if it's only bus activatable
+        if (!m_bus.isConnected())
+            return false;
+
+        // listen first, so that no seat falls between the list and the signals
+        m_bus.connect(LOGIN1_SERVICE, LOGIN1_PATH, LOGIN1_MANAGER, QStringLiteral("SeatNew"),
+                      this, SLOT(seatNew(QString,QDBusObjectPath)));
+        m_bus.connect(LOGIN1_SERVICE, LOGIN1_PATH, LOGIN1_MANAGER, QStringLiteral("SeatRemoved"),
+                      this, SLOT(seatGone(QString,QDBusObjectPath)));
+
+        QDBusMessage message = QDBusMessage::createMethodCall(LOGIN1_SERVICE, LOGIN1_PATH,
+                                                              LOGIN1_MANAGER, QStringLiteral("ListSeats"));
+        QDBusPendingCallWatcher *call = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+        connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)), this, SLOT(listFinished(QDBusPendingCallWatcher*)));
+
+        return true;
+    }
+
+    QStringList SeatWatcher::seats() const {
+        return m_graphical.toList();
+    }
+
+    void SeatWatcher::seatNew(const QString &name, const QDBusObjectPath &path) {
+        watchSeat(name, path.path());
+    }
+
+    void SeatWatcher::seatGone(const QString &name, const QDBusObjectPath &path) {
+        if (!m_paths.contains(name))
+            return;
+
+        qCDebug(SDDM_SEAT) << "Seat" << name << "removed";
+
+        m_bus.disconnect(LOGIN1_SERVICE, path.path(), PROPERTIES, QStringLiteral("PropertiesChanged"),
+                         this, SLOT(propertiesChanged(QDBusMessage)));
+        m_paths.remove(name);
+        setCanGraphical(name, false);
+        m_canTTY.remove(name);
+    }
+
+    void SeatWatcher::listFinished(QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<NamedSeatPathList> reply = *call;
+        if (reply.isError()) {
+            if (reply.error().type() == QDBusError::ServiceUnknown)
+                qCWarning(SDDM_SEAT) << "logind isn't running";
+            else
+                qCWarning(SDDM_SEAT) << "Failed to list the seats:" << reply.error().message();
+            emit listFailed();
+            return;
+        }
+
+        for (const NamedSeatPath &seat : reply.value())
+            watchSeat(seat.name, seat.path.path());
+    }
+
+    void SeatWatcher::propertiesFinished(QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        // the seat may be gone already, or even back with another path
+        const QString name = call->property("seat").toString();
+        if (m_paths.value(name) != call->property("path").toString())
+            return;
+
+        QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            // the seat exists at least, and only seat0 ever has the VTs
+            qCWarning(SDDM_SEAT) << "Failed to read the properties of seat" << name << ":" << reply.error().message();
+            m_canTTY.insert(name, name == QLatin1String("seat0"));
+            setCanGraphical(name, true);
+            return;
+        }
+
+        // logind older than 222 doesn't know CanGraphical
+        const QVariantMap properties = reply.value();
+        m_canTTY.insert(name, properties.value(CAN_TTY).toBool());
+        setCanGraphical(name, properties.value(CAN_GRAPHICAL, true).toBool());
+    }
+
+    void SeatWatcher::propertiesChanged(const QDBusMessage &message) {
+        const QList<QVariant> arguments = message.arguments();
+        if (arguments.size() < 3 || arguments.at(0).toString() != LOGIN1_SEAT)
+            return;
+
+        const QString name = m_paths.key(message.path());
+        if (name.isEmpty())
+            return;
+
+        const QVariantMap changed = qdbus_cast<QVariantMap>(arguments.at(1));
+        if (changed.contains(CAN_GRAPHICAL))
+            setCanGraphical(name, changed.value(CAN_GRAPHICAL).toBool());
+        else if (arguments.at(2).toStringList().contains(CAN_GRAPHICAL))
+            queryProperties(name);
+    }
+
+    void SeatWatcher::watchSeat(const QString &name, const QString &path) {
+        if (m_paths.contains(name))
+            return;
+
+        qCDebug(SDDM_SEAT) << "Seat" << name << "found at" << path;
+
+        m_paths.insert(name, path);
+        m_bus.connect(LOGIN1_SERVICE, path, PROPERTIES, QStringLiteral("PropertiesChanged"),
+                      this, SLOT(propertiesChanged(QDBusMessage)));
+        queryProperties(name);
+    }
+
+    void SeatWatcher::queryProperties(const QString &name) {
+        const QString path = m_paths.value(name);
+
+        // CanGraphical and CanTTY in one go
+        QDBusMessage message = QDBusMessage::createMethodCall(LOGIN1_SERVICE, path, PROPERTIES, QStringLiteral("GetAll"));
+        message << LOGIN1_SEAT;
+
+        QDBusPendingCallWatcher *call = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+        call->setProperty("seat", name);
+        call->setProperty("path", path);
+        connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)), this, SLOT(propertiesFinished(QDBusPendingCallWatcher*)));
+    }
+
+    void SeatWatcher::setCanGraphical(const QString &name, bool canGraphical) {
+        if (canGraphical == m_graphical.contains(name))
+            return;
+
+        if (canGraphical) {
+            qCDebug(SDDM_SEAT) << "Seat" << name << "can show graphics";
+            m_graphical.insert(name);
+            emit seatAdded(name, m_canTTY.value(name));
+        } else {
+            m_graphical.remove(name);
+            emit seatRemoved(name);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Seat enumeration through logind
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_SEATWATCHER_H
+#define SDDM_SEATWATCHER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusObjectPath>
+
+class QDBusMessage;
+class QDBusPendingCallWatcher;
+
+namespace SDDM {
+    /**
+    * A seat as listed by logind's ListSeats and announced by SeatNew
+    */
+    struct NamedSeatPath {
+        QString name;
+        QDBusObjectPath path;
+    };
+    typedef QList<NamedSeatPath> NamedSeatPathList;
+
+    QDBusArgument &operator<<(QDBusArgument &argument, const NamedSeatPath &seat);
+    const QDBusArgument &operator>>(const QDBusArgument &argument, NamedSeatPath &seat);
+
+    /**
+    * \brief
+    * Follows the seats logind knows about
+    *
+    * \section description
+    * \ref seatAdded is emitted for every seat which can show graphics,
+    * either when it's found or as soon as its CanGraphical property turns
+    * true, for instance when the graphics driver of a secondary card
+    * finished loading. \ref seatRemoved is emitted when such a seat goes
+    * away or can't show graphics anymore. Along with a new seat comes its
+    * CanTTY property, whether it has the virtual terminals.
+    *
+    * Nothing blocks, the seats are listed and their properties read with
+    * asynchronous calls.
+    */
+    class SeatWatcher : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(SeatWatcher)
+    public:
+        explicit SeatWatcher(const QDBusConnection &bus, QObject *parent = nullptr);
+
+        /**
+        * Starts following the seats, \ref listFailed follows if logind
+        * isn't running on the bus
+        * @return false if there's no bus connection
+        */
+        bool start();
+
+        /**
+        * Seats which can currently show graphics
+        */
+        QStringList seats() const;
+
+    signals:
+        void seatAdded(const QString &name, bool canTTY);
+        void seatRemoved(const QString &name);
+
+        /**
+        * The seats couldn't be listed, logind isn't there or failed to
+        * answer. Only the seats it announces from now on will be added.
+        */
+        void listFailed();
+
+    private slots:
+        void seatNew(const QString &name, const QDBusObjectPath &path);
+        void seatGone(const QString &name, const QDBusObjectPath &path);
+        void listFinished(QDBusPendingCallWatcher *call);
+        void propertiesFinished(QDBusPendingCallWatcher *call);
+        void propertiesChanged(const QDBusMessage &message);
+
+    private:
+        void watchSeat(const QString &name, const QString &path);
+        void queryProperties(const QString &name);
+        void setCanGraphical(const QString &name, bool canGraphical);
+
+        QDBusConnection m_bus;
+        QHash<QString, QString> m_paths;
+        QHash<QString, bool> m_canTTY;
+        QSet<QString> m_graphical;
+    };
+}
+
+Q_DECLARE_METATYPE(SDDM::NamedSeatPath)
+Q_DECLARE_METATYPE(SDDM::NamedSeatPathList)
+
+#endif // SDDM_SEATWATCHER_H
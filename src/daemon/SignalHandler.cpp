@@ -18,6 +18,7 @@
 ***************************************************************************/
 
 #include "SignalHandler.h"
+#include "LoggingCategories.h"
 
 #include <QDebug>
 #include <QSocketNotifier>
@@ -35,25 +36,25 @@ namespace SDDM {
 
     SignalHandler::SignalHandler(QObject *parent) : QObject(parent) {
         if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sighupFd))
-            qCritical() << "Failed to create socket pair for SIGHUP handling.";
+            qCCritical(SDDM_DAEMON) << "Failed to create socket pair for SIGHUP handling.";
 
         snhup = new QSocketNotifier(sighupFd[1], QSocketNotifier::Read, this);
         connect(snhup, SIGNAL(activated(int)), this, SLOT(handleSighup()));
 
         if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sigintFd))
-            qCritical() << "Failed to create socket pair for SIGINT handling.";
+            qCCritical(SDDM_DAEMON) << "Failed to create socket pair for SIGINT handling.";
 
         snint = new QSocketNotifier(sigintFd[1], QSocketNotifier::Read, this);
         connect(snint, SIGNAL(activated(int)), this, SLOT(handleSigint()));
 
         if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sigtermFd))
-            qCritical() << "Failed to create socket pair for SIGTERM handling.";
+            qCCritical(SDDM_DAEMON) << "Failed to create socket pair for SIGTERM handling.";
 
         snterm = new QSocketNotifier(sigtermFd[1], QSocketNotifier::Read, this);
         connect(snterm, SIGNAL(activated(int)), this, SLOT(handleSigterm()));
 
         if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sigusr1Fd))
-            qCritical() << "Failed to create socket pair for SIGUSR1 handling.";
+            qCCritical(SDDM_DAEMON) << "Failed to create socket pair for SIGUSR1 handling.";
 
         snusr1 = new QSocketNotifier(sigusr1Fd[1], QSocketNotifier::Read, this);
         connect(snusr1, SIGNAL(activated(int)), this, SLOT(handleSigusr1()));
@@ -66,7 +67,7 @@ namespace SDDM {
         sighup.sa_flags = SA_RESTART;
 
         if (sigaction(SIGHUP, &sighup, 0) > 0) {
-            qCritical() << "Failed to setup SIGHUP handler.";
+            qCCritical(SDDM_DAEMON) << "Failed to setup SIGHUP handler.";
             return;
         }
 
@@ -76,7 +77,7 @@ namespace SDDM {
         sigint.sa_flags = SA_RESTART;
 
         if (sigaction(SIGINT, &sigint, 0) > 0) {
-            qCritical() << "Failed to set up SIGINT handler.";
+            qCCritical(SDDM_DAEMON) << "Failed to set up SIGINT handler.";
             return;
         }
 
@@ -86,7 +87,7 @@ namespace SDDM {
         sigterm.sa_flags = SA_RESTART;
 
         if (sigaction(SIGTERM, &sigterm, 0) > 0) {
-            qCritical() << "Failed to set up SIGTERM handler.";
+            qCCritical(SDDM_DAEMON) << "Failed to set up SIGTERM handler.";
             return;
         }
     }
@@ -98,7 +99,7 @@ namespace SDDM {
         sigusr1.sa_flags = SA_RESTART;
 
         if (sigaction(SIGUSR1, &sigusr1, 0) > 0) {
-            qCritical() << "Failed to set up SIGUSR1 handler.";
+            qCCritical(SDDM_DAEMON) << "Failed to set up SIGUSR1 handler.";
             return;
         }
     }
@@ -110,7 +111,7 @@ namespace SDDM {
         sigusr1.sa_flags = SA_RESTART;
 
         if (sigaction(SIGUSR1, &sigusr1, 0) > 0) {
-            qCritical() << "Failed to set up SIGUSR1 handler.";
+            qCCritical(SDDM_DAEMON) << "Failed to set up SIGUSR1 handler.";
             return;
         }
     }
@@ -118,7 +119,7 @@ namespace SDDM {
     void SignalHandler::hupSignalHandler(int) {
         char a = 1;
         if (::write(sighupFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGHUP handler";
+            qCCritical(SDDM_DAEMON) << "Error writing to the SIGHUP handler";
             return;
         }
     }
@@ -126,7 +127,7 @@ namespace SDDM {
     void SignalHandler::intSignalHandler(int) {
         char a = 1;
         if (::write(sigintFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGINT handler";
+            qCCritical(SDDM_DAEMON) << "Error writing to the SIGINT handler";
             return;
         }
     }
@@ -134,7 +135,7 @@ namespace SDDM {
     void SignalHandler::termSignalHandler(int) {
         char a = 1;
         if (::write(sigtermFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGTERM handler";
+            qCCritical(SDDM_DAEMON) << "Error writing to the SIGTERM handler";
             return;
         }
     }
@@ -142,7 +143,7 @@ namespace SDDM {
     void SignalHandler::usr1SignalHandler(int) {
         char a = 1;
         if (::write(sigusr1Fd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGUSR1 handler";
+            qCCritical(SDDM_DAEMON) << "Error writing to the SIGUSR1 handler";
             return;
         }
     }
@@ -155,12 +156,12 @@ namespace SDDM {
         char a;
         if (::read(sighupFd[1], &a, sizeof(a)) == -1) {
             // something went wrong!
-            qCritical() << "Error reading from the socket";
+            qCCritical(SDDM_DAEMON) << "Error reading from the socket";
             return;
         }
 
         // log event
-        qWarning() << "Signal received: SIGHUP";
+        qCWarning(SDDM_DAEMON) << "Signal received: SIGHUP";
 
         // emit signal
         emit sighupReceived();
@@ -177,12 +178,12 @@ namespace SDDM {
         char a;
         if (::read(sigintFd[1], &a, sizeof(a)) == -1) {
             // something went wrong!
-            qCritical() << "Error reading from the socket";
+            qCCritical(SDDM_DAEMON) << "Error reading from the socket";
             return;
         }
 
         // log event
-        qWarning() << "Signal received: SIGINT";
+        qCWarning(SDDM_DAEMON) << "Signal received: SIGINT";
 
         // emit signal
         emit sigintReceived();
@@ -199,12 +200,12 @@ namespace SDDM {
         char a;
         if (::read(sigtermFd[1], &a, sizeof(a)) == -1) {
             // something went wrong!
-            qCritical() << "Error reading from the socket";
+            qCCritical(SDDM_DAEMON) << "Error reading from the socket";
             return;
         }
 
         // log event
-        qWarning() << "Signal received: SIGTERM";
+        qCWarning(SDDM_DAEMON) << "Signal received: SIGTERM";
 
         // emit signal
         emit sigtermReceived();
@@ -221,12 +222,12 @@ namespace SDDM {
         char a;
         if (::read(sigusr1Fd[1], &a, sizeof(a)) == -1) {
             // something went wrong!
-            qCritical() << "Error reading from the socket";
+            qCCritical(SDDM_DAEMON) << "Error reading from the socket";
             return;
         }
 
         // log event
-        qWarning() << "Signal received: SIGUSR1";
+        qCWarning(SDDM_DAEMON) << "Signal received: SIGUSR1";
 
         // emit signal
         emit sigusr1Received();
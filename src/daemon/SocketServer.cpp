@@ -21,15 +21,27 @@
 #include "SocketServer.h"
 
 #include "DaemonApp.h"
+#include "Display.h"
+#include "GreeterSnapshotCache.h"
+#include "LoggingCategories.h"
 #include "Messages.h"
 #include "PowerManager.h"
 #include "SocketWriter.h"
+#include "StartupTrace.h"
 #include "Utils.h"
 
 #include <QLocalServer>
+#include <QLocalSocket>
+
+#include <sys/socket.h>
 
 namespace SDDM {
     SocketServer::SocketServer(QObject *parent) : QObject(parent) {
+        // keep the greeters up to date
+        connect(daemonApp->powerManager(), SIGNAL(capabilitiesChanged(Capabilities)),
+                this, SLOT(capabilitiesChanged(Capabilities)));
+        connect(daemonApp->greeterSnapshotCache(), SIGNAL(hostNameChanged(QString)),
+                this, SLOT(hostNameChanged(QString)));
     }
 
     QString SocketServer::socketAddress() const {
@@ -38,15 +50,21 @@ namespace SDDM {
         return QString();
     }
 
+    void SocketServer::setTheme(const QString &themePath) {
+        m_themePath = themePath;
+    }
+
     bool SocketServer::start(const QString &displayName) {
         // check if the server has been created already
         if (m_server)
             return false;
 
+        StartupTrace::Span span(QStringLiteral("SocketServer::start"), terminalId());
+
         QString socketName = QStringLiteral("sddm-%1-%2").arg(displayName).arg(generateName(6));
 
         // log message
-        qDebug() << "Socket server starting...";
+        qCDebug(SDDM_SOCKET) << "Socket server starting...";
 
         // create server
         m_server = new QLocalServer(this);
@@ -57,7 +75,7 @@ namespace SDDM {
         // start listening
         if (!m_server->listen(socketName)) {
             // log message
-            qCritical() << "Failed to start socket server.";
+            qCCritical(SDDM_SOCKET) << "Failed to start socket server.";
 
             // return fail
             return false;
@@ -65,7 +83,7 @@ namespace SDDM {
 
 
         // log message
-        qDebug() << "Socket server started.";
+        qCDebug(SDDM_SOCKET) << "Socket server started.";
 
         // connect signals
         connect(m_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
@@ -80,14 +98,32 @@ namespace SDDM {
             return;
 
         // log message
-        qDebug() << "Socket server stopping...";
+        qCDebug(SDDM_SOCKET) << "Socket server stopping...";
 
         // delete server
         m_server->deleteLater();
         m_server = nullptr;
+        m_greeters.clear();
 
         // log message
-        qDebug() << "Socket server stopped.";
+        qCDebug(SDDM_SOCKET) << "Socket server stopped.";
+    }
+
+    QList<qint64> SocketServer::greeterProcessIds() const {
+        QList<qint64> pids;
+        for (QLocalSocket *socket : m_greeters) {
+            struct ucred cred;
+            socklen_t length = sizeof(cred);
+            if (getsockopt(int(socket->socketDescriptor()), SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0)
+                pids << cred.pid;
+        }
+        return pids;
+    }
+
+    int SocketServer::terminalId() const {
+        // keeps the timeline of each display on its own row
+        Display *display = qobject_cast<Display *>(parent());
+        return display ? display->terminalId() : 0;
     }
 
     void SocketServer::newConnection() {
@@ -96,9 +132,40 @@ namespace SDDM {
 
         // connect signals
         connect(socket, SIGNAL(readyRead()), this, SLOT(readyRead()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
         connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
     }
 
+    void SocketServer::disconnected() {
+        m_greeters.removeAll(qobject_cast<QLocalSocket *>(sender()));
+    }
+
+    void SocketServer::startPowerAction(QLocalSocket *socket, Capability action) {
+        PowerAction *job = daemonApp->powerManager()->start(action);
+        m_powerActions.insert(job, socket);
+        connect(job, SIGNAL(finished()), this, SLOT(powerActionFinished()));
+    }
+
+    void SocketServer::powerActionFinished() {
+        PowerAction *job = qobject_cast<PowerAction *>(sender());
+        QPointer<QLocalSocket> socket = m_powerActions.take(job);
+
+        // tell whoever asked, if it's still around
+        if (socket)
+            SocketWriter(socket) << quint32(DaemonMessages::PowerActionFinished)
+                                 << quint32(job->action()) << quint32(job->result());
+    }
+
+    void SocketServer::capabilitiesChanged(Capabilities capabilities) {
+        for (QLocalSocket *socket : m_greeters)
+            SocketWriter(socket) << quint32(DaemonMessages::Capabilities) << quint32(capabilities);
+    }
+
+    void SocketServer::hostNameChanged(const QString &hostName) {
+        for (QLocalSocket *socket : m_greeters)
+            SocketWriter(socket) << quint32(DaemonMessages::HostName) << hostName;
+    }
+
     void SocketServer::readyRead() {
         QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
 
@@ -116,13 +183,14 @@ namespace SDDM {
         switch (GreeterMessages(message)) {
             case GreeterMessages::Connect: {
                 // log message
-                qDebug() << "Message received from greeter: Connect";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: Connect";
 
-                // send capabilities
-                SocketWriter(socket) << quint32(DaemonMessages::Capabilities) << quint32(daemonApp->powerManager()->capabilities());
-
-                // send host name
-                SocketWriter(socket) << quint32(DaemonMessages::HostName) << daemonApp->hostName();
+                // send everything the greeter starts with in one go, as
+                // cached, updates follow when they change
+                SocketWriter(socket) << quint32(DaemonMessages::Handshake)
+                                     << daemonApp->greeterSnapshotCache()->snapshot(m_themePath);
+                if (!m_greeters.contains(socket))
+                    m_greeters << socket;
 
                 // emit signal
                 emit connected();
@@ -130,60 +198,88 @@ namespace SDDM {
             break;
             case GreeterMessages::Login: {
                 // log message
-                qDebug() << "Message received from greeter: Login";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: Login";
 
                 // read username, pasword etc.
                 QString user, password, filename;
                 Session session;
-                input >> user >> password >> session;
+                qint64 requested = 0;
+                input >> user >> password >> session >> requested;
+
+                // start timing the login
+                LoginTrace trace(LoginTrace::newId());
+                trace.setUser(user);
+                trace.mark(QStringLiteral("GreeterProxy::login"), requested);
+                trace.mark(QStringLiteral("SocketServer"));
 
                 // emit signal
-                emit login(socket, user, password, session);
+                emit login(socket, user, password, session, trace);
+            }
+            break;
+            case GreeterMessages::PrepareLogin: {
+                // log message
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: PrepareLogin";
+
+                // read username
+                QString user;
+                input >> user;
+
+                // emit signal
+                emit prepareLogin(user);
+            }
+            break;
+            case GreeterMessages::Trace: {
+                // span of the greeter's own startup
+                QString name;
+                qint64 start = 0, end = 0;
+                input >> name >> start >> end;
+
+                StartupTrace::addSpan(name, QStringLiteral("sddm-greeter"), start, end, terminalId());
             }
             break;
             case GreeterMessages::PowerOff: {
                 // log message
-                qDebug() << "Message received from greeter: PowerOff";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: PowerOff";
 
                 // power off
-                daemonApp->powerManager()->powerOff();
+                startPowerAction(socket, Capability::PowerOff);
             }
             break;
             case GreeterMessages::Reboot: {
                 // log message
-                qDebug() << "Message received from greeter: Reboot";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: Reboot";
 
                 // reboot
-                daemonApp->powerManager()->reboot();
+                startPowerAction(socket, Capability::Reboot);
             }
             break;
             case GreeterMessages::Suspend: {
                 // log message
-                qDebug() << "Message received from greeter: Suspend";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: Suspend";
 
                 // suspend
-                daemonApp->powerManager()->suspend();
+                startPowerAction(socket, Capability::Suspend);
             }
             break;
             case GreeterMessages::Hibernate: {
                 // log message
-                qDebug() << "Message received from greeter: Hibernate";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: Hibernate";
 
                 // hibernate
-                daemonApp->powerManager()->hibernate();
+                startPowerAction(socket, Capability::Hibernate);
             }
             break;
             case GreeterMessages::HybridSleep: {
                 // log message
-                qDebug() << "Message received from greeter: HybridSleep";
+                qCDebug(SDDM_SOCKET) << "Message received from greeter: HybridSleep";
 
                 // hybrid sleep
-                daemonApp->powerManager()->hybridSleep();
+                startPowerAction(socket, Capability::HybridSleep);
             }
             break;
             default: {
                 // log message
-                qWarning() << "Unknown message" << message;
+                qCWarning(SDDM_SOCKET) << "Unknown message" << message;
             }
         }
     }
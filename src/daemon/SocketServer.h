@@ -21,15 +21,22 @@
 #ifndef SDDM_SOCKETSERVER_H
 #define SDDM_SOCKETSERVER_H
 
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 
+#include "LoginTrace.h"
+#include "Messages.h"
 #include "Session.h"
 
 class QLocalServer;
 class QLocalSocket;
 
 namespace SDDM {
+    class PowerAction;
+
     class SocketServer : public QObject {
         Q_OBJECT
         Q_DISABLE_COPY(SocketServer)
@@ -41,9 +48,25 @@ namespace SDDM {
 
         QString socketAddress() const;
 
+        /**
+        * Theme of the greeter, whose configuration is sent along
+        * on Connect
+        */
+        void setTheme(const QString &themePath);
+
+        /**
+        * Process ids of the greeters which have connected, as the
+        * kernel reports them for their sockets
+        */
+        QList<qint64> greeterProcessIds() const;
+
     private slots:
         void newConnection();
+        void disconnected();
         void readyRead();
+        void capabilitiesChanged(Capabilities capabilities);
+        void hostNameChanged(const QString &hostName);
+        void powerActionFinished();
 
         void loginFailed(QLocalSocket *socket);
         void loginSucceeded(QLocalSocket *socket);
@@ -51,11 +74,18 @@ namespace SDDM {
     signals:
         void login(QLocalSocket *socket,
                    const QString &user, const QString &password,
-                   const Session &session);
+                   const Session &session, const LoginTrace &trace);
+        void prepareLogin(const QString &user);
         void connected();
 
     private:
+        int terminalId() const;
+        void startPowerAction(QLocalSocket *socket, Capability action);
+
         QLocalServer *m_server { nullptr };
+        QString m_themePath;
+        QList<QLocalSocket *> m_greeters;
+        QHash<PowerAction *, QPointer<QLocalSocket>> m_powerActions;
     };
 }
 
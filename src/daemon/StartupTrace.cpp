@@ -0,0 +1,134 @@
+/*
+ * Startup timeline in the Chrome trace event format
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "StartupTrace.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+// batches the rewrites while everything is starting up
+#define SAVE_DELAY 500
+
+// a daemon left running with tracing on shouldn't grow forever
+#define MAX_EVENTS 10000
+
+namespace SDDM {
+    struct TraceState {
+        QString file;
+        QStringList processes;
+        QJsonArray events;
+        bool saveScheduled { false };
+    };
+
+    static TraceState *state() {
+        static TraceState s;
+        return &s;
+    }
+
+    void StartupTrace::start(const QString &file) {
+        state()->file = file;
+        qCDebug(SDDM_DAEMON) << "Recording the startup trace to" << file;
+    }
+
+    bool StartupTrace::isEnabled() {
+        return !state()->file.isEmpty();
+    }
+
+    void StartupTrace::addSpan(const QString &name, const QString &process, qint64 start, qint64 end, int thread) {
+        TraceState *s = state();
+        if (s->file.isEmpty() || start <= 0 || end < start || s->events.size() >= MAX_EVENTS)
+            return;
+
+        // pids are only used to group the rows, the viewer shows the name
+        int pid = s->processes.indexOf(process) + 1;
+        if (pid == 0) {
+            s->processes << process;
+            pid = s->processes.size();
+            s->events.append(QJsonObject {
+                { QStringLiteral("name"), QStringLiteral("process_name") },
+                { QStringLiteral("ph"), QStringLiteral("M") },
+                { QStringLiteral("pid"), pid },
+                { QStringLiteral("args"), QJsonObject { { QStringLiteral("name"), process } } }
+            });
+        }
+
+        s->events.append(QJsonObject {
+            { QStringLiteral("name"), name },
+            { QStringLiteral("cat"), QStringLiteral("startup") },
+            { QStringLiteral("ph"), QStringLiteral("X") },
+            { QStringLiteral("ts"), double(start) },
+            { QStringLiteral("dur"), double(end - start) },
+            { QStringLiteral("pid"), pid },
+            { QStringLiteral("tid"), thread }
+        });
+
+        if (!s->saveScheduled) {
+            s->saveScheduled = true;
+            QTimer::singleShot(SAVE_DELAY, &StartupTrace::save);
+        }
+    }
+
+    void StartupTrace::addPhases(const LoginTrace &trace, const QString &process, int thread) {
+        const auto marks = trace.marks();
+        for (int i = 1; i < marks.size(); ++i)
+            addSpan(marks[i].first, process, marks[i - 1].second, marks[i].second, thread);
+    }
+
+    void StartupTrace::save() {
+        TraceState *s = state();
+        s->saveScheduled = false;
+
+        QJsonObject root {
+            { QStringLiteral("traceEvents"), s->events },
+            { QStringLiteral("displayTimeUnit"), QStringLiteral("ms") }
+        };
+
+        QSaveFile file(s->file);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qCWarning(SDDM_DAEMON) << "Failed to write the startup trace to" << s->file << ":" << file.errorString();
+            return;
+        }
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (!file.commit())
+            qCWarning(SDDM_DAEMON) << "Failed to write the startup trace to" << s->file << ":" << file.errorString();
+    }
+
+    StartupTrace::Span::Span(const QString &name, int thread) : m_name(name), m_thread(thread) {
+        if (isEnabled())
+            m_start = LoginTrace::now();
+    }
+
+    StartupTrace::Span::~Span() {
+        end();
+    }
+
+    void StartupTrace::Span::end() {
+        if (m_start == 0)
+            return;
+        addSpan(m_name, QStringLiteral("sddm"), m_start, LoginTrace::now(), m_thread);
+        m_start = 0;
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Startup timeline in the Chrome trace event format
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_STARTUPTRACE_H
+#define SDDM_STARTUPTRACE_H
+
+#include "LoginTrace.h"
+
+#include <QtCore/QString>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Records spans of the daemon, helper and greeter startup into a file
+    *
+    * \section description
+    * Enabled with `sddm --trace <file>`. Every span is written as a
+    * complete ("X") event of the Chrome trace event format, so the file can
+    * be opened in chrome://tracing or any other viewer of that format.
+    *
+    * Timestamps are those of \ref LoginTrace::now, the greeter and the
+    * helper take their own and send them over their sockets. Each program
+    * gets its own process row in the viewer, and each display its own
+    * thread row, keyed by its VT.
+    *
+    * The file is rewritten shortly after spans are added.
+    */
+    class StartupTrace {
+    public:
+        /**
+        * Starts recording into \a file
+        */
+        static void start(const QString &file);
+
+        static bool isEnabled();
+
+        /**
+        * Records a span, does nothing unless recording
+        * @param name what happened
+        * @param process program it happened in, "sddm", "sddm-helper"...
+        * @param start when it started, as returned by \ref LoginTrace::now
+        * @param end when it ended
+        * @param thread row within the program, usually the VT
+        */
+        static void addSpan(const QString &name, const QString &process,
+                            qint64 start, qint64 end = LoginTrace::now(), int thread = 0);
+
+        /**
+        * Records a span between each pair of consecutive phases of \a trace
+        */
+        static void addPhases(const LoginTrace &trace, const QString &process, int thread = 0);
+
+        /**
+        * Span of the daemon from construction to destruction or \ref end
+        */
+        class Span {
+        public:
+            explicit Span(const QString &name, int thread = 0);
+            ~Span();
+
+            void end();
+
+        private:
+            QString m_name;
+            qint64 m_start { 0 };
+            int m_thread { 0 };
+        };
+
+    private:
+        static void save();
+    };
+}
+
+#endif // SDDM_STARTUPTRACE_H
@@ -17,10 +17,14 @@
 * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 ***************************************************************************/
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QSocketNotifier>
 #include <QString>
+#include <QThread>
 
 #include "VirtualTerminal.h"
+#include "LoggingCategories.h"
 
 #include <errno.h>
 #include <string.h>
@@ -30,22 +34,24 @@
 #include <linux/vt.h>
 #include <linux/kd.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
 #define RELEASE_DISPLAY_SIGNAL (SIGRTMAX)
 #define ACQUIRE_DISPLAY_SIGNAL (SIGRTMAX - 1)
 
 namespace SDDM {
     namespace VirtualTerminal {
-        static void onAcquireDisplay(int signal) {
-            int fd = open("/dev/tty0", O_RDWR | O_NOCTTY);
-            ioctl(fd, VT_RELDISP, VT_ACKACQ);
-            close(fd);
-        }
-
-        static void onReleaseDisplay(int signal) {
-            int fd = open("/dev/tty0", O_RDWR | O_NOCTTY);
-            ioctl(fd, VT_RELDISP, 1);
-            close(fd);
+        // written to by the signal handler, read by the Switcher
+        static int vtSignalFd[2] = { -1, -1 };
+
+        static void onVtSignal(int signal) {
+            // nothing but write() is safe in here
+            int savedErrno = errno;
+            char which = signal == RELEASE_DISPLAY_SIGNAL ? 'r' : 'a';
+            if (::write(vtSignalFd[0], &which, sizeof(which)) < 0) {
+                // the pipe is full of acknowledgements still to be sent
+            }
+            errno = savedErrno;
         }
 
         static bool handleVtSwitches(int fd) {
@@ -57,12 +63,16 @@ namespace SDDM {
             setModeRequest.acqsig = ACQUIRE_DISPLAY_SIGNAL;
 
             if (ioctl(fd, VT_SETMODE, &setModeRequest) < 0) {
-                qDebug() << "Failed to manage VT manually:" << strerror(errno);
+                qCDebug(SDDM_VT) << "Failed to manage VT manually:" << strerror(errno);
                 ok = false;
             }
 
-            signal(RELEASE_DISPLAY_SIGNAL, onReleaseDisplay);
-            signal(ACQUIRE_DISPLAY_SIGNAL, onAcquireDisplay);
+            struct sigaction action = { };
+            action.sa_handler = onVtSignal;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            sigaction(RELEASE_DISPLAY_SIGNAL, &action, nullptr);
+            sigaction(ACQUIRE_DISPLAY_SIGNAL, &action, nullptr);
 
             return ok;
         }
@@ -74,7 +84,7 @@ namespace SDDM {
             bool ok = true;
 
             if (ioctl(fd, VT_GETMODE, &getmodeReply) < 0) {
-                qWarning() << "Failed to query VT mode:" << strerror(errno);
+                qCWarning(SDDM_VT) << "Failed to query VT mode:" << strerror(errno);
                 ok = false;
             }
 
@@ -82,7 +92,7 @@ namespace SDDM {
                 goto out;
 
             if (ioctl(fd, KDGETMODE, &kernelDisplayMode) < 0) {
-                qWarning() << "Failed to query kernel display mode:" << strerror(errno);
+                qCWarning(SDDM_VT) << "Failed to query kernel display mode:" << strerror(errno);
                 ok = false;
             }
 
@@ -94,51 +104,36 @@ namespace SDDM {
             modeFixed = true;
 out:
             if (!ok) {
-                qCritical() << "Failed to set up VT mode";
+                qCCritical(SDDM_VT) << "Failed to set up VT mode";
                 return;
             }
 
             if (modeFixed)
-                qDebug() << "VT mode fixed";
+                qCDebug(SDDM_VT) << "VT mode fixed";
             else
-                qDebug() << "VT mode didn't need to be fixed";
+                qCDebug(SDDM_VT) << "VT mode didn't need to be fixed";
         }
 
-        int setUpNewVt() {
-            // open VT master
-            int fd = open("/dev/tty0", O_RDWR | O_NOCTTY);
+        int activeVt() {
+            int fd = open("/dev/tty0", O_RDONLY | O_NOCTTY);
             if (fd < 0) {
-                qCritical() << "Failed to open VT master:" << strerror(errno);
+                qCWarning(SDDM_VT) << "Failed to open VT master:" << strerror(errno);
                 return -1;
             }
 
             vt_stat vtState = { 0 };
-            if (ioctl(fd, VT_GETSTATE, &vtState) < 0) {
-                qCritical() << "Failed to get current VT:" << strerror(errno);
-                close(fd);
-                return -1;
-            }
-
-            int vt = 0;
-            if (ioctl(fd, VT_OPENQRY, &vt) < 0) {
-                qCritical() << "Failed to open new VT:" << strerror(errno);
-                close(fd);
-                return -1;
-            }
-
+            int result = ioctl(fd, VT_GETSTATE, &vtState);
             close(fd);
-
-            // fallback to active VT
-            if (vt <= 0) {
-                qWarning() << "New VT" << vt << "is not valid, fall back to" << vtState.v_active;
-                return vtState.v_active;
+            if (result < 0) {
+                qCWarning(SDDM_VT) << "Failed to get current VT:" << strerror(errno);
+                return -1;
             }
 
-            return vt;
+            return vtState.v_active;
         }
 
-        void jumpToVt(int vt) {
-            qDebug() << "Jumping to VT" << vt;
+        static bool switchToVt(int vt) {
+            qCDebug(SDDM_VT) << "Jumping to VT" << vt;
 
             int fd;
 
@@ -151,7 +146,7 @@ out:
 
                 // set graphics mode to prevent flickering
                 if (ioctl(fd, KDSETMODE, KD_GRAPHICS) < 0)
-                    qWarning("Failed to set graphics mode for VT %d: %s", vt, strerror(errno));
+                    qCWarning(SDDM_VT, "Failed to set graphics mode for VT %d: %s", vt, strerror(errno));
 
                 // it's possible that the current VT was left in a broken
                 // combination of states (KD_GRAPHICS with VT_AUTO) that we
@@ -159,19 +154,198 @@ out:
                 // will make VT_ACTIVATE work without hanging VT_WAITACTIVE
                 fixVtMode(activeVtFd);
             } else {
-                qWarning("Failed to open %s: %s", qPrintable(ttyString), strerror(errno));
-                qDebug("Using /dev/tty0 instead of %s!", qPrintable(ttyString));
+                qCWarning(SDDM_VT, "Failed to open %s: %s", qPrintable(ttyString), strerror(errno));
+                qCDebug(SDDM_VT, "Using /dev/tty0 instead of %s!", qPrintable(ttyString));
                 fd = activeVtFd;
             }
 
             handleVtSwitches(fd);
 
+            bool ok = false;
             if (ioctl(fd, VT_ACTIVATE, vt) < 0)
-                qWarning("Couldn't initiate jump to VT %d: %s", vt, strerror(errno));
+                qCWarning(SDDM_VT, "Couldn't initiate jump to VT %d: %s", vt, strerror(errno));
             else if (ioctl(fd, VT_WAITACTIVE, vt) < 0)
-                qWarning("Couldn't finalize jump to VT %d: %s", vt, strerror(errno));
+                qCWarning(SDDM_VT, "Couldn't finalize jump to VT %d: %s", vt, strerror(errno));
+            else
+                ok = true;
 
             close(activeVtFd);
+
+            return ok;
+        }
+
+        void jumpToVt(int vt) {
+            Switcher::instance()->jumpToVt(vt);
+        }
+
+        Allocator *Allocator::instance() {
+            static Allocator self;
+            return &self;
+        }
+
+        Allocator::~Allocator() {
+            for (const Reservation &reservation : m_reservations)
+                if (reservation.fd >= 0)
+                    close(reservation.fd);
+        }
+
+        int Allocator::reserve(int minimum, const QString &owner) {
+            // the table is ordered, the first gap is the VT
+            int vt = minimum;
+            for (auto it = m_reservations.lowerBound(minimum); it != m_reservations.end() && it.key() == vt; ++it)
+                ++vt;
+
+            m_reservations[vt].owner = owner;
+            return vt;
+        }
+
+        int Allocator::allocate(const QString &owner) {
+            int fd = open("/dev/tty0", O_RDWR | O_NOCTTY);
+            if (fd < 0) {
+                qCCritical(SDDM_VT) << "Failed to open VT master:" << strerror(errno);
+                return -1;
+            }
+
+            vt_stat vtState = { 0 };
+            if (ioctl(fd, VT_GETSTATE, &vtState) < 0) {
+                qCCritical(SDDM_VT) << "Failed to get current VT:" << strerror(errno);
+                close(fd);
+                return -1;
+            }
+
+            int vt = 0;
+            if (ioctl(fd, VT_OPENQRY, &vt) < 0) {
+                qCCritical(SDDM_VT) << "Failed to open new VT:" << strerror(errno);
+                close(fd);
+                return -1;
+            }
+
+            close(fd);
+
+            if (vt <= 0) {
+                qCWarning(SDDM_VT) << "New VT" << vt << "is not valid";
+                return -1;
+            }
+
+            // the kernel doesn't know about the VTs reserved for display
+            // servers which haven't opened theirs yet, nor about the ones
+            // past 15 in its state
+            while (m_reservations.contains(vt) ||
+                   (vt < 16 && (vtState.v_state & (1 << vt))))
+                ++vt;
+
+            QString ttyString = QStringLiteral("/dev/tty%1").arg(vt);
+            int vtFd = open(qPrintable(ttyString), O_RDWR | O_NOCTTY | O_CLOEXEC);
+            if (vtFd < 0) {
+                qCCritical(SDDM_VT, "Failed to open %s: %s", qPrintable(ttyString), strerror(errno));
+                return -1;
+            }
+
+            Reservation &reservation = m_reservations[vt];
+            reservation.owner = owner;
+            reservation.fd = vtFd;
+
+            qCDebug(SDDM_VT) << "Allocated VT" << vt << "for" << owner;
+            return vt;
+        }
+
+        void Allocator::handOver(int vt) {
+            auto it = m_reservations.find(vt);
+            if (it == m_reservations.end() || it->fd < 0)
+                return;
+
+            close(it->fd);
+            it->fd = -1;
+        }
+
+        void Allocator::release(int vt) {
+            auto it = m_reservations.find(vt);
+            if (it == m_reservations.end())
+                return;
+
+            if (it->fd >= 0)
+                close(it->fd);
+            m_reservations.erase(it);
+        }
+
+        QStringList Allocator::usage() const {
+            QStringList usage;
+            for (auto it = m_reservations.constBegin(); it != m_reservations.constEnd(); ++it) {
+                QString line = QStringLiteral("%1 %2").arg(it.key()).arg(it->owner);
+                if (it->fd >= 0)
+                    line += QStringLiteral(" (held)");
+                usage << line;
+            }
+            return usage;
+        }
+
+        /**
+        * Lives on the Switcher's thread, its queued slot calls
+        * are the queue of switches
+        */
+        class SwitchWorker : public QObject {
+            Q_OBJECT
+        public slots:
+            void jump(int vt) {
+                emit jumped(vt, switchToVt(vt));
+            }
+
+        signals:
+            void jumped(int vt, bool success);
+        };
+
+        Switcher *Switcher::instance() {
+            static Switcher *self = new Switcher(QCoreApplication::instance());
+            return self;
+        }
+
+        Switcher::Switcher(QObject *parent) : QObject(parent) {
+            if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, vtSignalFd) < 0)
+                qCCritical(SDDM_VT) << "Failed to create socket pair for VT signal handling:" << strerror(errno);
+
+            m_notifier = new QSocketNotifier(vtSignalFd[1], QSocketNotifier::Read, this);
+            connect(m_notifier, SIGNAL(activated(int)), this, SLOT(acknowledge()));
+
+            m_thread = new QThread();
+            m_thread->setObjectName(QStringLiteral("VT switcher"));
+            m_worker = new SwitchWorker();
+            m_worker->moveToThread(m_thread);
+            connect(m_thread, SIGNAL(finished()), m_worker, SLOT(deleteLater()));
+            connect(m_worker, SIGNAL(jumped(int,bool)), this, SIGNAL(jumped(int,bool)));
+            m_thread->start();
+        }
+
+        Switcher::~Switcher() {
+            m_thread->quit();
+
+            // a switch nobody acknowledges anymore never finishes,
+            // leave the thread to the exit rather than hanging it
+            if (m_thread->wait(1000))
+                delete m_thread;
+            else
+                qCWarning(SDDM_VT) << "Still switching VTs while exiting";
+        }
+
+        void Switcher::jumpToVt(int vt) {
+            QMetaObject::invokeMethod(m_worker, "jump", Qt::QueuedConnection, Q_ARG(int, vt));
+        }
+
+        void Switcher::acknowledge() {
+            char which;
+            while (::read(vtSignalFd[1], &which, sizeof(which)) == sizeof(which)) {
+                int fd = open("/dev/tty0", O_RDWR | O_NOCTTY);
+                if (fd < 0) {
+                    qCWarning(SDDM_VT) << "Failed to open VT master:" << strerror(errno);
+                    continue;
+                }
+                if (which == 'r')
+                    ioctl(fd, VT_RELDISP, 1);
+                else
+                    ioctl(fd, VT_RELDISP, VT_ACKACQ);
+                close(fd);
+            }
         }
     }
 }
+
+#include "VirtualTerminal.moc"
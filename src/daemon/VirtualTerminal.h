@@ -20,10 +20,112 @@
 #ifndef SDDM_VIRTUALTERMINAL_H
 #define SDDM_VIRTUALTERMINAL_H
 
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+
+class QSocketNotifier;
+class QThread;
+
 namespace SDDM {
     namespace VirtualTerminal {
-        int setUpNewVt();
+        int activeVt();
+
+        /**
+        * Starts switching to \a vt and returns right away,
+        * Switcher::jumped is emitted once the switch is done
+        */
         void jumpToVt(int vt);
+
+        /**
+        * \brief
+        * Switches VTs on a thread of its own
+        *
+        * \section description
+        * Switching waits for the kernel, and for whoever owns the VT to
+        * let go of it, so switches are queued to a worker thread and done
+        * one after the other.
+        *
+        * The VT release and acquire signals are forwarded through a pipe
+        * and acknowledged from the main event loop, never from the signal
+        * handler nor from the worker, which may be waiting for that very
+        * acknowledgement.
+        */
+        class Switcher : public QObject {
+            Q_OBJECT
+            Q_DISABLE_COPY(Switcher)
+        public:
+            static Switcher *instance();
+            ~Switcher();
+
+            void jumpToVt(int vt);
+
+        signals:
+            void jumped(int vt, bool success);
+
+        private slots:
+            void acknowledge();
+
+        private:
+            explicit Switcher(QObject *parent);
+
+            QThread *m_thread { nullptr };
+            QObject *m_worker { nullptr };
+            QSocketNotifier *m_notifier { nullptr };
+        };
+
+        /**
+        * \brief
+        * Keeps track of the VTs handed out to displays and sessions
+        *
+        * \section description
+        * Every VT in use by a display or a session is in the reservation
+        * table until it's released, so no two of them get the same one.
+        * A VT allocated for a session is also held open until it's handed
+        * over to the session, which keeps the kernel from offering it to
+        * anyone else in the meantime.
+        */
+        class Allocator {
+        public:
+            static Allocator *instance();
+
+            /**
+            * Reserves the lowest VT from \a minimum on which isn't reserved
+            * @param owner who it's for, as shown by \ref usage
+            */
+            int reserve(int minimum, const QString &owner);
+
+            /**
+            * Reserves a VT nothing has open, and holds it open
+            * @param owner who it's for, as shown by \ref usage
+            * @return the VT, or -1 if there's none
+            */
+            int allocate(const QString &owner);
+
+            /**
+            * Stops holding \a vt open, the session has opened it by now,
+            * it stays reserved until it's released
+            */
+            void handOver(int vt);
+
+            void release(int vt);
+
+            /**
+            * One line per reserved VT: its number, owner and whether it's
+            * still held open
+            */
+            QStringList usage() const;
+
+        private:
+            Allocator() { }
+            ~Allocator();
+
+            struct Reservation {
+                QString owner;
+                int fd { -1 };
+            };
+            QMap<int, Reservation> m_reservations;
+        };
     }
 }
 
@@ -23,20 +23,35 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "Display.h"
+#include "HookRunner.h"
+#include "LoggingCategories.h"
+#include "Seat.h"
 #include "SignalHandler.h"
+#include "StartupTrace.h"
+#include "XAuth.h"
 
+#include <QDataStream>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QLocalSocket>
 #include <QProcess>
+#include <QSocketNotifier>
+#include <QTimer>
 #include <QUuid>
 
-#include <random>
-
 #include <xcb/xcb.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <pwd.h>
+#include <signal.h>
+#include <string.h>
 #include <unistd.h>
 
+// how often to check whether the server is done resetting
+#define RESET_PROBE_INTERVAL 50
+
 namespace SDDM {
     XorgDisplayServer::XorgDisplayServer(Display *parent) : DisplayServer(parent) {
         // get auth directory
@@ -53,17 +68,7 @@ namespace SDDM {
         m_authPath = QStringLiteral("%1/%2").arg(authDir).arg(QUuid::createUuid().toString());
 
         // generate cookie
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 15);
-
-        // resever 32 bytes
-        m_cookie.reserve(32);
-
-        // create a random hexadecimal number
-        const char *digits = "0123456789abcdef";
-        for (int i = 0; i < 32; ++i)
-            m_cookie[i] = digits[dis(gen)];
+        m_cookie = XAuth::generateCookie();
     }
 
     XorgDisplayServer::~XorgDisplayServer() {
@@ -86,34 +91,24 @@ namespace SDDM {
         return m_cookie;
     }
 
+    qint64 XorgDisplayServer::processId() const {
+        return process ? process->processId() : 0;
+    }
+
     void XorgDisplayServer::addCookie(const QString &file) {
         // log message
-        qDebug() << "Adding cookie to" << file;
-
-        // Touch file
-        QFile file_handler(file);
-        file_handler.open(QIODevice::WriteOnly);
-        file_handler.close();
-
-        QString cmd = QStringLiteral("%1 -f %2 -q").arg(mainConfig.X11.XauthPath.get()).arg(file);
-
-        // execute xauth
-        FILE *fp = popen(qPrintable(cmd), "w");
+        qCDebug(SDDM_DISPLAY) << "Adding cookie to" << file;
 
-        // check file
-        if (!fp)
-            return;
-        fprintf(fp, "remove %s\n", qPrintable(m_display));
-        fprintf(fp, "add %s . %s\n", qPrintable(m_display), qPrintable(m_cookie));
-        fprintf(fp, "exit\n");
+        QElapsedTimer timer;
+        timer.start();
 
-        // close pipe
-        pclose(fp);
+        if (XAuth::addCookie(file, m_display, m_cookie))
+            qCDebug(SDDM_DISPLAY) << "Cookie written in" << timer.nsecsElapsed() / 1000 << "us";
     }
 
     bool XorgDisplayServer::start() {
         // check flag
-        if (m_started)
+        if (m_started || process)
             return false;
 
         // create process
@@ -121,25 +116,26 @@ namespace SDDM {
 
         // delete process on finish
         connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(finished()));
+        connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(processError()));
 
         // log message
-        qDebug() << "Display server starting...";
+        qCDebug(SDDM_DISPLAY) << "Display server starting...";
+        m_startTime = LoginTrace::now();
+
+        // nothing is ever blocking on the server, give up if it doesn't
+        // come up in time
+        m_startTimer = new QTimer(this);
+        m_startTimer->setSingleShot(true);
+        connect(m_startTimer, SIGNAL(timeout()), this, SLOT(startTimedOut()));
+        m_startTimer->start(mainConfig.X11.ServerTimeout.get() * 1000);
 
         if (daemonApp->testing()) {
+            // the display is known already, Xephyr is usable once running
+            connect(process, SIGNAL(started()), this, SLOT(serverReady()));
+
             QStringList args;
             args << m_display << QStringLiteral("-ac") << QStringLiteral("-br") << QStringLiteral("-noreset") << QStringLiteral("-screen") << QStringLiteral("800x600");
             process->start(mainConfig.X11.XephyrPath.get(), args);
-
-
-            // wait for display server to start
-            if (!process->waitForStarted()) {
-                // log message
-                qCritical() << "Failed to start display server process.";
-
-                // return fail
-                return false;
-            }
-            emit started();
         } else {
             // set process environment
             QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -150,72 +146,155 @@ namespace SDDM {
             //0 == read from X, 1== write to from X
             int pipeFds[2];
             if (pipe(pipeFds) != 0) {
-                qCritical("Could not create pipe to start X server");
+                qCCritical(SDDM_DISPLAY, "Could not create pipe to start X server");
+                cancelStart();
+                return false;
             }
 
+            // only the X server gets the write end, and we never block on ours
+            fcntl(pipeFds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(pipeFds[0], F_SETFL, O_NONBLOCK);
+
             // start display server
             QStringList args = mainConfig.X11.ServerArguments.get().split(QLatin1Char(' '), QString::SkipEmptyParts);
             args << QStringLiteral("-auth") << m_authPath
                  << QStringLiteral("-background") << QStringLiteral("none")
                  << QStringLiteral("-noreset")
                  << QStringLiteral("-displayfd") << QString::number(pipeFds[1])
-                 << QStringLiteral("vt%1").arg(displayPtr()->terminalId());
-            qDebug() << "Running:"
+                 << QStringLiteral("-seat") << displayPtr()->seat()->name();
+            if (displayPtr()->seat()->hasVirtualTerminals())
+                args << QStringLiteral("vt%1").arg(displayPtr()->terminalId());
+            qCDebug(SDDM_DISPLAY) << "Running:"
                      << qPrintable(mainConfig.X11.ServerPath.get())
                      << qPrintable(args.join(QLatin1Char(' ')));
             process->start(mainConfig.X11.ServerPath.get(), args);
 
-            // wait for display server to start
-            if (!process->waitForStarted()) {
-                // log message
-                qCritical() << "Failed to start display server process.";
-
-                // return fail
-                close(pipeFds[0]);
-                return false;
-            }
-
-            // close the other side of pipe in our process, otherwise reading
-            // from it may stuck even X server exit.
+            // the server has its copy once forked, closing ours means we see
+            // the end of the pipe if it exits without writing to it
             close(pipeFds[1]);
 
-            QFile readPipe;
+            // the display number arrives in serverReadable()
+            m_displayFd = pipeFds[0];
+            m_displayFdNotifier = new QSocketNotifier(m_displayFd, QSocketNotifier::Read, this);
+            connect(m_displayFdNotifier, SIGNAL(activated(int)), this, SLOT(serverReadable()));
+        }
 
-            if (!readPipe.open(pipeFds[0], QIODevice::ReadOnly)) {
-                qCritical("Failed to open pipe to start X Server ");
+        // return success
+        return true;
+    }
 
-                close(pipeFds[0]);
-                return false;
+    void XorgDisplayServer::serverReadable() {
+        char buffer[32];
+        ssize_t length;
+        while ((length = ::read(m_displayFd, buffer, sizeof(buffer))) > 0)
+            m_displayNumber.append(buffer, length);
+
+        // the number is terminated by a newline, whether or not the server
+        // closes its end after writing it
+        int newline = m_displayNumber.indexOf('\n');
+        if (newline < 0) {
+            if (length < 0 && (errno == EAGAIN || errno == EINTR))
+                return;
+
+            // the server went away before writing it
+            if (length == 0) {
+                startFailed(QStringLiteral("X server closed the display pipe without reporting a display"));
+            }
+            else if (length < 0) {
+                startFailed(QStringLiteral("Failed to read the display from the X server: %1")
+                            .arg(QString::fromLocal8Bit(strerror(errno))));
             }
-            QByteArray displayNumber = readPipe.readLine();
-            displayNumber.prepend(QByteArray(":"));
-            displayNumber.remove(displayNumber.size() -1, 1); //trim trailing whitespace
-            m_display = QString::fromLocal8Bit(displayNumber);
-    
-            // close our pipe
-            close(pipeFds[0]);
-
-            emit started();
+            return;
         }
 
+        m_display = QStringLiteral(":") + QString::fromLocal8Bit(m_displayNumber.left(newline).trimmed());
+        serverReady();
+    }
+
+    void XorgDisplayServer::serverReady() {
+        cleanupStart();
+
+        const int vt = displayPtr()->terminalId();
+        StartupTrace::addSpan(QStringLiteral("X server start"), QStringLiteral("sddm"), m_startTime, LoginTrace::now(), vt);
+
         // generate auth file
+        StartupTrace::Span span(QStringLiteral("addCookie"), vt);
         addCookie(m_authPath);
         changeOwner(m_authPath);
+        span.end();
 
         // set flag
         m_started = true;
 
-        // return success
-        return true;
+        qCDebug(SDDM_DISPLAY) << "Display server started on" << m_display;
+        emit started();
+    }
+
+    void XorgDisplayServer::processError() {
+        // crashes are handled by finished()
+        if (!m_started && process && process->error() == QProcess::FailedToStart)
+            startFailed(QStringLiteral("Failed to start display server process: %1").arg(process->errorString()));
+    }
+
+    void XorgDisplayServer::startTimedOut() {
+        startFailed(QStringLiteral("Display server didn't report its display within %1 seconds")
+                    .arg(mainConfig.X11.ServerTimeout.get()));
+    }
+
+    void XorgDisplayServer::startFailed(const QString &reason) {
+        qCCritical(SDDM_DISPLAY) << qPrintable(reason);
+        cancelStart();
+        emit failed();
+    }
+
+    void XorgDisplayServer::cancelStart() {
+        cleanupStart();
+
+        if (!process)
+            return;
+
+        // let it die on its own, deleting a running QProcess blocks
+        process->disconnect(this);
+        if (process->state() == QProcess::NotRunning) {
+            process->deleteLater();
+        } else {
+            connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), process, SLOT(deleteLater()));
+            process->kill();
+        }
+        process = nullptr;
+    }
+
+    void XorgDisplayServer::cleanupStart() {
+        delete m_startTimer;
+        m_startTimer = nullptr;
+
+        // may be called from the notifier's own signal
+        if (m_displayFdNotifier) {
+            m_displayFdNotifier->setEnabled(false);
+            m_displayFdNotifier->deleteLater();
+            m_displayFdNotifier = nullptr;
+        }
+
+        if (m_displayFd >= 0) {
+            close(m_displayFd);
+            m_displayFd = -1;
+        }
+        m_displayNumber.clear();
     }
 
     void XorgDisplayServer::stop() {
+        // still starting, nobody has been told about it yet
+        if (!m_started && process) {
+            cancelStart();
+            return;
+        }
+
         // check flag
         if (!m_started)
             return;
 
         // log message
-        qDebug() << "Display server stopping...";
+        qCDebug(SDDM_DISPLAY) << "Display server stopping...";
 
         // terminate process
         process->terminate();
@@ -225,7 +304,200 @@ namespace SDDM {
             process->kill();
     }
 
+    bool XorgDisplayServer::reset() {
+        if (!m_started || !process || process->state() != QProcess::Running || m_setupHooks || m_resetTimer)
+            return false;
+
+        // the server only resets once it gets back to its dispatch loop,
+        // clients connecting before that would be dropped by the reset.
+        // Whether a client is accepted doesn't tell, with -ac or host
+        // based access it'd be accepted either way, so a connection made
+        // beforehand is held until the reset closes it.
+        qCDebug(SDDM_DISPLAY) << "Display server resetting...";
+        m_resetTimer = new QTimer(this);
+        m_resetTimer->setSingleShot(true);
+        connect(m_resetTimer, SIGNAL(timeout()), this, SLOT(resetTimedOut()));
+        m_resetTimer->start(mainConfig.X11.ServerTimeout.get() * 1000);
+
+        m_resetSentinel = new QLocalSocket(this);
+        connect(m_resetSentinel, SIGNAL(connected()), this, SLOT(sentinelConnected()));
+        connect(m_resetSentinel, SIGNAL(readyRead()), this, SLOT(sentinelReadable()));
+        connect(m_resetSentinel, SIGNAL(disconnected()), this, SLOT(sentinelClosed()));
+        connect(m_resetSentinel, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(sentinelClosed()));
+        m_resetSentinel->connectToServer(socketPath());
+
+        return true;
+    }
+
+    QString XorgDisplayServer::socketPath() const {
+        return QStringLiteral("/tmp/.X11-unix/X%1").arg(m_display.mid(1).section(QLatin1Char('.'), 0, 0));
+    }
+
+    QByteArray XorgDisplayServer::connectionSetup() const {
+        const QByteArray name("MIT-MAGIC-COOKIE-1");
+        const QByteArray data = QByteArray::fromHex(m_cookie.toLatin1());
+
+        // byte order, protocol version 11.0, then the authorization
+        // name and data, each padded to 4 bytes
+        QByteArray request;
+        QDataStream stream(&request, QIODevice::WriteOnly);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream << quint8('l') << quint8(0) << quint16(11) << quint16(0)
+               << quint16(name.size()) << quint16(data.size()) << quint16(0);
+        request.append(name).append(QByteArray((4 - name.size() % 4) % 4, '\0'));
+        request.append(data).append(QByteArray((4 - data.size() % 4) % 4, '\0'));
+        return request;
+    }
+
+    void XorgDisplayServer::sentinelConnected() {
+        // with the cookie the server has now
+        m_resetSentinel->write(connectionSetup());
+    }
+
+    void XorgDisplayServer::sentinelReadable() {
+        // the rest of the setup reply is of no interest
+        if (m_hangupSent) {
+            m_resetSentinel->readAll();
+            return;
+        }
+
+        // 1 for success
+        char status = 0;
+        if (!m_resetSentinel->getChar(&status))
+            return;
+        if (status != 1) {
+            resetFailed(QStringLiteral("it refused a connection before resetting"));
+            return;
+        }
+
+        // the server loads the authority file again after resetting
+        m_cookie = XAuth::generateCookie();
+        addCookie(m_authPath);
+        changeOwner(m_authPath);
+
+        // SIGHUP resets the server even with -noreset: every client is
+        // disconnected and the root window, properties, grabs, keyboard
+        // settings and so on are all set back to their defaults
+        if (::kill(pid_t(process->processId()), SIGHUP) != 0) {
+            resetFailed(QString::fromLocal8Bit(strerror(errno)));
+            return;
+        }
+        m_hangupSent = true;
+        m_resetSentinel->readAll();
+    }
+
+    void XorgDisplayServer::sentinelClosed() {
+        if (!m_resetSentinel)
+            return;
+
+        if (!m_hangupSent) {
+            resetFailed(QStringLiteral("it dropped a connection before resetting"));
+            return;
+        }
+
+        // the reset disconnected it, the server is back in its dispatch
+        // loop and only knows the new cookie
+        QLocalSocket *sentinel = m_resetSentinel;
+        m_resetSentinel = nullptr;
+        sentinel->disconnect(this);
+        sentinel->deleteLater();
+        probeReset();
+    }
+
+    void XorgDisplayServer::probeReset() {
+        if (!m_resetTimer || m_resetProbe || m_resetSentinel)
+            return;
+
+        m_resetProbe = new QLocalSocket(this);
+        connect(m_resetProbe, SIGNAL(connected()), this, SLOT(probeConnected()));
+        connect(m_resetProbe, SIGNAL(readyRead()), this, SLOT(probeReadable()));
+        connect(m_resetProbe, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(probeFailed()));
+        m_resetProbe->connectToServer(socketPath());
+    }
+
+    void XorgDisplayServer::probeConnected() {
+        m_resetProbe->write(connectionSetup());
+    }
+
+    void XorgDisplayServer::probeReadable() {
+        // 1 for success, anything else is the reset not being through
+        char status = 0;
+        if (!m_resetProbe->getChar(&status))
+            return;
+        dropResetProbe();
+
+        if (status != 1) {
+            QTimer::singleShot(RESET_PROBE_INTERVAL, this, SLOT(probeReset()));
+            return;
+        }
+
+        endReset();
+        qCDebug(SDDM_DISPLAY) << "Display server reset";
+        setupDisplay();
+    }
+
+    void XorgDisplayServer::probeFailed() {
+        // not listening yet
+        dropResetProbe();
+        QTimer::singleShot(RESET_PROBE_INTERVAL, this, SLOT(probeReset()));
+    }
+
+    void XorgDisplayServer::resetTimedOut() {
+        qCCritical(SDDM_DISPLAY) << "Display server didn't accept clients within"
+                                 << mainConfig.X11.ServerTimeout.get() << "seconds of resetting";
+        endReset();
+
+        // finished() reports it as stopped
+        if (process)
+            process->terminate();
+    }
+
+    void XorgDisplayServer::resetFailed(const QString &reason) {
+        qCWarning(SDDM_DISPLAY) << "Failed to reset the display server," << qPrintable(reason);
+        endReset();
+
+        // whoever is still connected may hold on to it, start over with
+        // a new one, finished() reports it as stopped
+        if (process)
+            process->terminate();
+    }
+
+    void XorgDisplayServer::endReset() {
+        dropResetProbe();
+
+        if (m_resetSentinel) {
+            // may be called from the sentinel's own signals
+            m_resetSentinel->disconnect(this);
+            m_resetSentinel->abort();
+            m_resetSentinel->deleteLater();
+            m_resetSentinel = nullptr;
+        }
+        m_hangupSent = false;
+
+        if (m_resetTimer) {
+            m_resetTimer->deleteLater();
+            m_resetTimer = nullptr;
+        }
+    }
+
+    void XorgDisplayServer::dropResetProbe() {
+        if (!m_resetProbe)
+            return;
+
+        // may be called from the probe's own signals
+        m_resetProbe->disconnect(this);
+        m_resetProbe->abort();
+        m_resetProbe->deleteLater();
+        m_resetProbe = nullptr;
+    }
+
     void XorgDisplayServer::finished() {
+        // died while starting
+        if (!m_started && process) {
+            startFailed(QStringLiteral("Display server exited before reporting its display"));
+            return;
+        }
+
         // check flag
         if (!m_started)
             return;
@@ -234,12 +506,20 @@ namespace SDDM {
         m_started = false;
 
         // log message
-        qDebug() << "Display server stopped.";
-
-        QString displayStopCommand = mainConfig.X11.DisplayStopCommand.get();
+        qCDebug(SDDM_DISPLAY) << "Display server stopped.";
+
+        // the display is gone, don't report it as ready
+        endReset();
+        if (m_setupHooks) {
+            // we may be inside one of its hooks' signals
+            m_setupHooks->disconnect(this);
+            m_setupHooks->deleteLater();
+            m_setupHooks = nullptr;
+        }
 
-        // create display setup script process
-        QProcess *displayStopScript = new QProcess();
+        // the display stop script outlives us, nothing waits for it
+        HookRunner *stopHooks = new HookRunner(daemonApp);
+        connect(stopHooks, SIGNAL(finished()), stopHooks, SLOT(deleteLater()));
 
         // set process environment
         QProcessEnvironment env;
@@ -247,19 +527,11 @@ namespace SDDM {
         env.insert(QStringLiteral("HOME"), QStringLiteral("/"));
         env.insert(QStringLiteral("PATH"), mainConfig.Users.DefaultPath.get());
         env.insert(QStringLiteral("SHELL"), QStringLiteral("/bin/sh"));
-        displayStopScript->setProcessEnvironment(env);
+        stopHooks->setProcessEnvironment(env);
 
         // start display stop script
-        qDebug() << "Running display stop script " << displayStopCommand;
-        displayStopScript->start(displayStopCommand);
-
-        // wait for finished
-        if (!displayStopScript->waitForFinished(5000))
-            displayStopScript->kill();
-
-        // clean up the script process
-        displayStopScript->deleteLater();
-        displayStopScript = nullptr;
+        stopHooks->addHook(QStringLiteral("Xstop"), mainConfig.X11.DisplayStopCommand.get(), 5000);
+        stopHooks->start();
 
         // clean up
         process->deleteLater();
@@ -273,10 +545,13 @@ namespace SDDM {
     }
 
     void XorgDisplayServer::setupDisplay() {
-        QString displayCommand = mainConfig.X11.DisplayCommand.get();
+        // already running
+        if (m_setupHooks)
+            return;
 
-        // create display setup script process
-        QProcess *displayScript = new QProcess();
+        m_setupHooks = new HookRunner(this);
+        connect(m_setupHooks, SIGNAL(ready()), this, SLOT(setupReady()));
+        connect(m_setupHooks, SIGNAL(finished()), this, SLOT(setupFinished()));
 
         // set process environment
         QProcessEnvironment env;
@@ -286,40 +561,41 @@ namespace SDDM {
         env.insert(QStringLiteral("XAUTHORITY"), m_authPath);
         env.insert(QStringLiteral("SHELL"), QStringLiteral("/bin/sh"));
         env.insert(QStringLiteral("XCURSOR_THEME"), mainConfig.Theme.CursorTheme.get());
-        displayScript->setProcessEnvironment(env);
+        m_setupHooks->setProcessEnvironment(env);
 
-        qDebug() << "Setting default cursor";
-        displayScript->start(QStringLiteral("xsetroot -cursor_name left_ptr"));
+        // the greeter sets its own cursor, only the root window needs one,
+        // so it runs alongside the display setup script and holds up nothing
+        m_setupHooks->addHook(QStringLiteral("xsetroot"), QStringLiteral("xsetroot -cursor_name left_ptr"), 1000,
+                              HookRunner::Parallel | HookRunner::NonBlocking);
 
-        // wait for finished
-        if (!displayScript->waitForFinished(1000)) {
-            qWarning() << "Could not setup default cursor";
-            displayScript->kill();
-        }
-
-        // delete displayScript on finish
-        connect(displayScript, SIGNAL(finished(int,QProcess::ExitStatus)), displayScript, SLOT(deleteLater()));
+        HookRunner::Flags setupFlags = HookRunner::Parallel;
+        if (!mainConfig.X11.WaitForDisplayCommand.get())
+            setupFlags |= HookRunner::NonBlocking;
+        m_setupHooks->addHook(QStringLiteral("Xsetup"), mainConfig.X11.DisplayCommand.get(), 30000, setupFlags);
 
-        // start display setup script
-        qDebug() << "Running display setup script " << displayCommand;
-        displayScript->start(displayCommand);
-
-        // wait for finished
-        if (!displayScript->waitForFinished(30000))
-            displayScript->kill();
+        m_setupHooks->start();
+    }
 
+    void XorgDisplayServer::setupReady() {
         // reload config if needed
         mainConfig.load();
+
+        emit ready();
+    }
+
+    void XorgDisplayServer::setupFinished() {
+        m_setupHooks->deleteLater();
+        m_setupHooks = nullptr;
     }
 
     void XorgDisplayServer::changeOwner(const QString &fileName) {
         // change the owner and group of the auth file to the sddm user
         struct passwd *pw = getpwnam("sddm");
         if (!pw)
-            qWarning() << "Failed to find the sddm user. Owner of the auth file will not be changed.";
+            qCWarning(SDDM_DISPLAY) << "Failed to find the sddm user. Owner of the auth file will not be changed.";
         else {
             if (chown(qPrintable(fileName), pw->pw_uid, pw->pw_gid) == -1)
-                qWarning() << "Failed to change owner of the auth file.";
+                qCWarning(SDDM_DISPLAY) << "Failed to change owner of the auth file.";
         }
     }
 }
@@ -23,9 +23,14 @@
 
 #include "DisplayServer.h"
 
+class QLocalSocket;
 class QProcess;
+class QSocketNotifier;
+class QTimer;
 
 namespace SDDM {
+    class HookRunner;
+
     class XorgDisplayServer : public DisplayServer {
         Q_OBJECT
         Q_DISABLE_COPY(XorgDisplayServer)
@@ -40,6 +45,8 @@ namespace SDDM {
 
         const QString &cookie() const;
 
+        qint64 processId() const;
+
         void addCookie(const QString &file);
 
     public slots:
@@ -47,13 +54,54 @@ namespace SDDM {
         void stop();
         void finished();
         void setupDisplay();
+        bool reset();
+
+    private slots:
+        void serverReadable();
+        void serverReady();
+        void processError();
+        void startTimedOut();
+        void setupReady();
+        void setupFinished();
+        void sentinelConnected();
+        void sentinelReadable();
+        void sentinelClosed();
+        void probeReset();
+        void probeConnected();
+        void probeReadable();
+        void probeFailed();
+        void resetTimedOut();
 
     private:
         QString m_authPath;
         QString m_cookie;
 
         QProcess *process { nullptr };
+        HookRunner *m_setupHooks { nullptr };
+
+        // -displayfd handshake
+        QTimer *m_startTimer { nullptr };
+        QSocketNotifier *m_displayFdNotifier { nullptr };
+        int m_displayFd { -1 };
+        qint64 m_startTime { 0 };
+        QByteArray m_displayNumber;
+
+        // waiting for the server to come back from a reset: the sentinel
+        // is connected before SIGHUP and closed by the reset, the probe
+        // then waits for the new cookie to be accepted
+        QTimer *m_resetTimer { nullptr };
+        QLocalSocket *m_resetSentinel { nullptr };
+        QLocalSocket *m_resetProbe { nullptr };
+        bool m_hangupSent { false };
 
+        void startFailed(const QString &reason);
+        void resetFailed(const QString &reason);
+        QString socketPath() const;
+        QByteArray connectionSetup() const;
+        void endReset();
+        void dropResetProbe();
+        void cancelStart();
+        void cleanupStart();
         void changeOwner(const QString &fileName);
     };
 }
@@ -21,13 +21,16 @@
 #include "GreeterApp.h"
 #include "Configuration.h"
 #include "GreeterProxy.h"
+#include "GreeterSnapshot.h"
 #include "Constants.h"
+#include "LoggingCategories.h"
 #include "ScreenModel.h"
 #include "SessionModel.h"
 #include "ThemeConfig.h"
 #include "ThemeMetadata.h"
 #include "UserModel.h"
 #include "KeyboardModel.h"
+#include "LoginTrace.h"
 
 #include "MessageHandler.h"
 
@@ -42,6 +45,8 @@
 
 #include <iostream>
 
+const int HANDSHAKE_TIMEOUT = 5000;
+
 namespace SDDM {
     QString parameter(const QStringList &arguments, const QString &key, const QString &defaultValue) {
         int index = arguments.indexOf(key);
@@ -58,6 +63,7 @@ namespace SDDM {
     }
 
     GreeterApp *GreeterApp::self = nullptr;
+    qint64 GreeterApp::startTime = 0;
 
     GreeterApp::GreeterApp(int &argc, char **argv) : QGuiApplication(argc, argv) {
         // point instance to this
@@ -69,16 +75,49 @@ namespace SDDM {
         if (arguments().contains(QStringLiteral("--test-mode")))
             testing = true;
 
+        // send the startup timeline to the daemon
+        m_tracing = arguments().contains(QStringLiteral("--trace"));
+        const qint64 appStarted = LoginTrace::now();
+
         // get socket name
         QString socket = parameter(arguments(), QStringLiteral("--socket"), QString());
 
-        // get theme path (fallback to internal theme)
-        m_themePath = parameter(arguments(), QStringLiteral("--theme"), QString());
-        if (m_themePath.isEmpty())
-            m_themePath = QLatin1String("qrc:/theme");
+        // connect to the daemon first, its handshake has the theme
+        // already read and what else is shown initially
+        m_proxy = new GreeterProxy(socket);
 
-        // read theme metadata
-        m_metadata = new ThemeMetadata(QStringLiteral("%1/metadata.desktop").arg(m_themePath));
+        if(!testing && !m_proxy->isConnected()) {
+            qCCritical(SDDM_GREETER) << "Cannot connect to the daemon - is it running?";
+            exit(EXIT_FAILURE);
+        }
+
+        // get theme path (fallback to internal theme)
+        const QString theme = parameter(arguments(), QStringLiteral("--theme"), QString());
+        m_themePath = theme.isEmpty() ? QStringLiteral("qrc:/theme") : theme;
+
+        const qint64 handshakeStarted = LoginTrace::now();
+        const bool snapshot = !testing && m_proxy->waitForSnapshot(HANDSHAKE_TIMEOUT) &&
+                              m_proxy->snapshot().themePath == theme;
+        const qint64 themeStarted = LoginTrace::now();
+
+        QString translationsDirectory;
+        if (snapshot) {
+            m_mainScript = m_proxy->snapshot().mainScript;
+            translationsDirectory = m_proxy->snapshot().translationsDirectory;
+            m_themeConfig = m_proxy->snapshot().themeConfig;
+
+            // the daemon's are the latest, it saves them
+            stateConfig.Last.User.set(m_proxy->snapshot().lastUser);
+            stateConfig.Last.Session.set(m_proxy->snapshot().lastSession);
+        } else {
+            // read theme metadata
+            ThemeMetadata metadata(QStringLiteral("%1/metadata.desktop").arg(m_themePath));
+            m_mainScript = metadata.mainScript();
+            translationsDirectory = metadata.translationsDirectory();
+
+            // read theme config
+            m_themeConfig = ThemeConfig(QStringLiteral("%1/%2").arg(m_themePath).arg(metadata.configFile()));
+        }
 
         // Translations
         // Components translation
@@ -89,29 +128,25 @@ namespace SDDM {
         // Theme specific translation
         m_theme_translator = new QTranslator();
         if (m_theme_translator->load(QLocale::system(), QString(), QString(),
-                           QStringLiteral("%1/%2/").arg(m_themePath, m_metadata->translationsDirectory())))
+                           QStringLiteral("%1/%2/").arg(m_themePath, translationsDirectory)))
             installTranslator(m_theme_translator);
 
-        // get theme config file
-        QString configFile = QStringLiteral("%1/%2").arg(m_themePath).arg(m_metadata->configFile());
-
-        // read theme config
-        m_themeConfig = new ThemeConfig(configFile);
-
         // set default icon theme from greeter theme
-        if (m_themeConfig->contains(QStringLiteral("iconTheme")))
-            QIcon::setThemeName(m_themeConfig->value(QStringLiteral("iconTheme")).toString());
+        if (m_themeConfig.contains(QStringLiteral("iconTheme")))
+            QIcon::setThemeName(m_themeConfig.value(QStringLiteral("iconTheme")).toString());
 
         // create models
+        const qint64 modelsStarted = LoginTrace::now();
 
         m_sessionModel = new SessionModel();
         m_userModel = new UserModel();
-        m_proxy = new GreeterProxy(socket);
         m_keyboard = new KeyboardModel();
 
-        if(!testing && !m_proxy->isConnected()) {
-            qCritical() << "Cannot connect to the daemon - is it running?";
-            exit(EXIT_FAILURE);
+        if (m_tracing) {
+            m_proxy->trace(QStringLiteral("greeter main()"), startTime, appStarted);
+            m_proxy->trace(QStringLiteral("handshake"), handshakeStarted, themeStarted);
+            m_proxy->trace(QStringLiteral("theme and translations"), themeStarted, modelsStarted);
+            m_proxy->trace(QStringLiteral("models"), modelsStarted, LoginTrace::now());
         }
 
         // Set numlock upon start
@@ -124,6 +159,10 @@ namespace SDDM {
 
         m_proxy->setSessionModel(m_sessionModel);
 
+        // most logins are by the preselected user, get them going whatever the theme does
+        if (m_proxy->isConnected() && !m_userModel->lastUser().isEmpty())
+            m_proxy->prepareLogin(m_userModel->lastUser());
+
         // create views
         QList<QScreen *> screens = primaryScreen()->virtualSiblings();
         Q_FOREACH (QScreen *screen, screens)
@@ -178,14 +217,14 @@ namespace SDDM {
         view->rootContext()->setContextProperty(QStringLiteral("sessionModel"), m_sessionModel);
         view->rootContext()->setContextProperty(QStringLiteral("screenModel"), screenModel);
         view->rootContext()->setContextProperty(QStringLiteral("userModel"), m_userModel);
-        view->rootContext()->setContextProperty(QStringLiteral("config"), *m_themeConfig);
+        view->rootContext()->setContextProperty(QStringLiteral("config"), m_themeConfig);
         view->rootContext()->setContextProperty(QStringLiteral("sddm"), m_proxy);
         view->rootContext()->setContextProperty(QStringLiteral("keyboard"), m_keyboard);
         view->rootContext()->setContextProperty(QStringLiteral("primaryScreen"), QGuiApplication::primaryScreen() == screen);
         view->rootContext()->setContextProperty(QStringLiteral("__sddm_errors"), QString());
 
         // get theme main script
-        QString mainScript = QStringLiteral("%1/%2").arg(m_themePath).arg(m_metadata->mainScript());
+        QString mainScript = QStringLiteral("%1/%2").arg(m_themePath).arg(m_mainScript);
         QUrl mainScriptUrl;
         if (m_themePath.startsWith(QLatin1String("qrc:/")))
             mainScriptUrl = QUrl(mainScript);
@@ -199,25 +238,38 @@ namespace SDDM {
 
             QString errors;
             Q_FOREACH(const QQmlError &e, view->errors()) {
-                qWarning() << e;
+                qCWarning(SDDM_GREETER) << e;
                 errors += QLatin1String("\n") + e.toString();
             }
 
-            qWarning() << "Fallback to embedded theme";
+            qCWarning(SDDM_GREETER) << "Fallback to embedded theme";
             view->rootContext()->setContextProperty(QStringLiteral("__sddm_errors"), errors);
             view->setSource(QUrl(QStringLiteral("qrc:/theme/Main.qml")));
         });
 
         // set main script as source
-        qInfo("Loading %s...", qPrintable(mainScriptUrl.toString()));
+        qCInfo(SDDM_GREETER, "Loading %s...", qPrintable(mainScriptUrl.toString()));
+        const qint64 loadStarted = LoginTrace::now();
         view->setSource(mainScriptUrl);
+        if (m_tracing) {
+            m_proxy->trace(QStringLiteral("QML load %1").arg(screen->name()), loadStarted, LoginTrace::now());
+
+            // from the start of the greeter up to the first frame
+            QMetaObject::Connection *firstFrame = new QMetaObject::Connection;
+            const QString screenName = screen->name();
+            *firstFrame = connect(view, &QQuickView::frameSwapped, this, [this, screenName, firstFrame]() {
+                m_proxy->trace(QStringLiteral("first frame %1").arg(screenName), startTime, LoginTrace::now());
+                disconnect(*firstFrame);
+                delete firstFrame;
+            });
+        }
 
         // set default cursor
         QCursor cursor(Qt::ArrowCursor);
         view->rootObject()->setCursor(cursor);
 
         // show
-        qDebug() << "Adding view for" << screen->name() << screen->geometry();
+        qCDebug(SDDM_GREETER) << "Adding view for" << screen->name() << screen->geometry();
         view->show();
 
         // activate windows for the primary screen to give focus to text fields
@@ -243,8 +295,11 @@ namespace SDDM {
 }
 
 int main(int argc, char **argv) {
+    SDDM::GreeterApp::startTime = SDDM::LoginTrace::now();
+
     // install message handler
     qInstallMessageHandler(SDDM::GreeterMessageHandler);
+    SDDM::setLoggingRules(SDDM::mainConfig.LoggingRules.get());
 
     // HiDPI
     bool hiDpiEnabled = false;
@@ -253,10 +308,10 @@ int main(int argc, char **argv) {
     else if (QGuiApplication::platformName().startsWith(QLatin1String("wayland")))
         hiDpiEnabled = SDDM::mainConfig.Wayland.EnableHiDPI.get();
     if (hiDpiEnabled) {
-        qDebug() << "High-DPI autoscaling Enabled";
+        qCDebug(SDDM_GREETER) << "High-DPI autoscaling Enabled";
         QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     } else {
-        qDebug() << "High-DPI autoscaling not Enabled";
+        qCDebug(SDDM_GREETER) << "High-DPI autoscaling not Enabled";
     }
 
     QStringList arguments;
@@ -269,7 +324,8 @@ int main(int argc, char **argv) {
                      "Options: \n"
                      "  --theme <theme path>       Set greeter theme\n"
                      "  --socket <socket name>     Set socket name\n"
-                     "  --test-mode                Start greeter in test mode" << std::endl;
+                     "  --test-mode                Start greeter in test mode\n"
+                     "  --trace                    Send the startup timeline to the daemon" << std::endl;
 
         return EXIT_FAILURE;
     }
@@ -24,13 +24,12 @@
 #include <QGuiApplication>
 #include <QScreen>
 #include <QQuickView>
+#include <QVariantMap>
 
 class QTranslator;
 
 namespace SDDM {
     class Configuration;
-    class ThemeMetadata;
-    class ThemeConfig;
     class SessionModel;
     class ScreenModel;
     class UserModel;
@@ -47,6 +46,11 @@ namespace SDDM {
 
         static GreeterApp *instance() { return self; }
 
+        /**
+        * When main() was entered, the start of the greeter's timeline
+        */
+        static qint64 startTime;
+
     private slots:
         void addViewForScreen(QScreen *screen);
         void removeViewForScreen(QQuickView *view);
@@ -59,13 +63,15 @@ namespace SDDM {
                     *m_components_tranlator { nullptr };
 
         QString m_themePath;
-        ThemeMetadata *m_metadata { nullptr };
-        ThemeConfig *m_themeConfig { nullptr };
+        QString m_mainScript;
+        QVariantMap m_themeConfig;
         SessionModel *m_sessionModel { nullptr };
         UserModel *m_userModel { nullptr };
         GreeterProxy *m_proxy { nullptr };
         KeyboardModel *m_keyboard { nullptr };
 
+        bool m_tracing { false };
+
         void activatePrimary();
     };
 }
@@ -21,10 +21,14 @@
 #include "GreeterProxy.h"
 
 #include "Configuration.h"
+#include "GreeterSnapshot.h"
+#include "LoggingCategories.h"
+#include "LoginTrace.h"
 #include "Messages.h"
 #include "SessionModel.h"
 #include "SocketWriter.h"
 
+#include <QElapsedTimer>
 #include <QLocalSocket>
 
 namespace SDDM {
@@ -33,6 +37,8 @@ namespace SDDM {
         SessionModel *sessionModel { nullptr };
         QLocalSocket *socket { nullptr };
         QString hostName;
+        GreeterSnapshot snapshot;
+        bool hasSnapshot { false };
         bool canPowerOff { false };
         bool canReboot { false };
         bool canSuspend { false };
@@ -88,6 +94,27 @@ namespace SDDM {
         return d->socket->state() == QLocalSocket::ConnectedState;
     }
 
+    bool GreeterProxy::waitForSnapshot(int msecs) {
+        QElapsedTimer timer;
+        timer.start();
+
+        // readyRead() is called from within as data comes in
+        while (!d->hasSnapshot && !timer.hasExpired(msecs)) {
+            if (!d->socket->waitForReadyRead(msecs - int(timer.elapsed())))
+                break;
+        }
+
+        return d->hasSnapshot;
+    }
+
+    bool GreeterProxy::hasSnapshot() const {
+        return d->hasSnapshot;
+    }
+
+    const GreeterSnapshot &GreeterProxy::snapshot() const {
+        return d->snapshot;
+    }
+
     void GreeterProxy::powerOff() {
         SocketWriter(d->socket) << quint32(GreeterMessages::PowerOff);
     }
@@ -109,9 +136,12 @@ namespace SDDM {
     }
 
     void GreeterProxy::login(const QString &user, const QString &password, const int sessionIndex) const {
+        // the daemon picks this up as the first phase of the login trace
+        qint64 requested = LoginTrace::now();
+
         if (!d->sessionModel) {
             // log error
-            qCritical() << "Session model is not set.";
+            qCCritical(SDDM_PROXY) << "Session model is not set.";
 
             // return
             return;
@@ -124,12 +154,20 @@ namespace SDDM {
         Session::Type type = static_cast<Session::Type>(d->sessionModel->data(index, SessionModel::TypeRole).toInt());
         QString name = d->sessionModel->data(index, SessionModel::FileRole).toString();
         Session session(type, name);
-        SocketWriter(d->socket) << quint32(GreeterMessages::Login) << user << password << session;
+        SocketWriter(d->socket) << quint32(GreeterMessages::Login) << user << password << session << requested;
+    }
+
+    void GreeterProxy::trace(const QString &name, qint64 start, qint64 end) {
+        SocketWriter(d->socket) << quint32(GreeterMessages::Trace) << name << start << end;
+    }
+
+    void GreeterProxy::prepareLogin(const QString &user) {
+        SocketWriter(d->socket) << quint32(GreeterMessages::PrepareLogin) << user;
     }
 
     void GreeterProxy::connected() {
         // log connection
-        qDebug() << "Connected to the daemon.";
+        qCDebug(SDDM_PROXY) << "Connected to the daemon.";
 
         // send connected message
         SocketWriter(d->socket) << quint32(GreeterMessages::Connect);
@@ -137,11 +175,11 @@ namespace SDDM {
 
     void GreeterProxy::disconnected() {
         // log disconnection
-        qDebug() << "Disconnected from the daemon.";
+        qCDebug(SDDM_PROXY) << "Disconnected from the daemon.";
     }
 
     void GreeterProxy::error() {
-        qCritical() << "Socket error: " << d->socket->errorString();
+        qCCritical(SDDM_PROXY) << "Socket error: " << d->socket->errorString();
     }
 
     void GreeterProxy::readyRead() {
@@ -156,30 +194,33 @@ namespace SDDM {
             switch (DaemonMessages(message)) {
                 case DaemonMessages::Capabilities: {
                     // log message
-                    qDebug() << "Message received from daemon: Capabilities";
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: Capabilities";
 
                     // read capabilities
                     quint32 capabilities;
                     input >> capabilities;
 
                     // parse capabilities
-                    d->canPowerOff = capabilities & Capability::PowerOff;
-                    d->canReboot = capabilities & Capability::Reboot;
-                    d->canSuspend = capabilities & Capability::Suspend;
-                    d->canHibernate = capabilities & Capability::Hibernate;
-                    d->canHybridSleep = capabilities & Capability::HybridSleep;
-
-                    // emit signals
-                    emit canPowerOffChanged(d->canPowerOff);
-                    emit canRebootChanged(d->canReboot);
-                    emit canSuspendChanged(d->canSuspend);
-                    emit canHibernateChanged(d->canHibernate);
-                    emit canHybridSleepChanged(d->canHybridSleep);
+                    setCapabilities(capabilities);
+                }
+                break;
+                case DaemonMessages::Handshake: {
+                    // log message
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: Handshake";
+
+                    // read snapshot
+                    input >> d->snapshot;
+                    d->hasSnapshot = true;
+
+                    // set host name and capabilities, the rest is picked up on start
+                    d->hostName = d->snapshot.hostName;
+                    emit hostNameChanged(d->hostName);
+                    setCapabilities(d->snapshot.capabilities);
                 }
                 break;
                 case DaemonMessages::HostName: {
                     // log message
-                    qDebug() << "Message received from daemon: HostName";
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: HostName";
 
                     // read host name
                     input >> d->hostName;
@@ -190,7 +231,7 @@ namespace SDDM {
                 break;
                 case DaemonMessages::LoginSucceeded: {
                     // log message
-                    qDebug() << "Message received from daemon: LoginSucceeded";
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: LoginSucceeded";
 
                     // emit signal
                     emit loginSucceeded();
@@ -198,17 +239,44 @@ namespace SDDM {
                 break;
                 case DaemonMessages::LoginFailed: {
                     // log message
-                    qDebug() << "Message received from daemon: LoginFailed";
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: LoginFailed";
 
                     // emit signal
                     emit loginFailed();
                 }
                 break;
+                case DaemonMessages::PowerActionFinished: {
+                    // log message
+                    qCDebug(SDDM_PROXY) << "Message received from daemon: PowerActionFinished";
+
+                    // read the action and how it went
+                    quint32 action, result;
+                    input >> action >> result;
+
+                    // emit signal
+                    emit powerActionFinished(action, result);
+                }
+                break;
                 default: {
                     // log message
-                    qWarning() << "Unknown message received from daemon.";
+                    qCWarning(SDDM_PROXY) << "Unknown message received from daemon.";
                 }
             }
         }
     }
+
+    void GreeterProxy::setCapabilities(quint32 capabilities) {
+        d->canPowerOff = capabilities & Capability::PowerOff;
+        d->canReboot = capabilities & Capability::Reboot;
+        d->canSuspend = capabilities & Capability::Suspend;
+        d->canHibernate = capabilities & Capability::Hibernate;
+        d->canHybridSleep = capabilities & Capability::HybridSleep;
+
+        // emit signals
+        emit canPowerOffChanged(d->canPowerOff);
+        emit canRebootChanged(d->canReboot);
+        emit canSuspendChanged(d->canSuspend);
+        emit canHibernateChanged(d->canHibernate);
+        emit canHybridSleepChanged(d->canHybridSleep);
+    }
 }
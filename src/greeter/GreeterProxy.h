@@ -26,6 +26,7 @@ class QLocalSocket;
 
 namespace SDDM {
     class SessionModel;
+    struct GreeterSnapshot;
 
     class GreeterProxyPrivate;
     class GreeterProxy : public QObject {
@@ -53,6 +54,14 @@ namespace SDDM {
 
         bool isConnected() const;
 
+        /**
+        * Waits up to \a msecs for the daemon's handshake
+        * @return true if it arrived, \ref snapshot has it then
+        */
+        bool waitForSnapshot(int msecs);
+        bool hasSnapshot() const;
+        const GreeterSnapshot &snapshot() const;
+
         void setSessionModel(SessionModel *model);
 
     public slots:
@@ -64,6 +73,20 @@ namespace SDDM {
 
         void login(const QString &user, const QString &password, const int sessionIndex) const;
 
+        /**
+        * Lets the daemon get the authentication of \a user going while the
+        * password is being typed, an empty user cancels it
+        */
+        void prepareLogin(const QString &user);
+
+        /**
+        * Adds a span of the greeter startup to the daemon's trace
+        * @param name what happened
+        * @param start start time as returned by \ref LoginTrace::now
+        * @param end end time
+        */
+        void trace(const QString &name, qint64 start, qint64 end);
+
     private slots:
         void connected();
         void disconnected();
@@ -81,7 +104,11 @@ namespace SDDM {
         void loginFailed();
         void loginSucceeded();
 
+        void powerActionFinished(int action, int result);
+
     private:
+        void setCapabilities(quint32 capabilities);
+
         GreeterProxyPrivate *d { nullptr };
     };
 }
@@ -24,6 +24,7 @@
 #include "KeyboardModel_p.h"
 #include "KeyboardLayout.h"
 #include "XcbKeyboardBackend.h"
+#include "LoggingCategories.h"
 
 #include <QSocketNotifier>
 
@@ -69,7 +70,7 @@ namespace SDDM {
         error = xcb_request_check(m_conn, cookie);
 
         if (error) {
-            qWarning() << "Can't update state: " << error->error_code;
+            qCWarning(SDDM_MODELS) << "Can't update state: " << error->error_code;
         }
     }
 
@@ -80,7 +81,7 @@ namespace SDDM {
 
         m_conn = xcb_connect(nullptr, nullptr);
         if (m_conn == nullptr) {
-            qCritical() << "xcb_connect failed, keyboard extension disabled";
+            qCCritical(SDDM_MODELS) << "xcb_connect failed, keyboard extension disabled";
             d->enabled = false;
             return;
         }
@@ -90,7 +91,7 @@ namespace SDDM {
         xcb_xkb_use_extension_reply(m_conn, cookie, &error);
 
         if (error != nullptr) {
-            qCritical() << "xcb_xkb_use_extension failed, extension disabled, error code"
+            qCCritical(SDDM_MODELS) << "xcb_xkb_use_extension failed, extension disabled, error code"
                         << error->error_code;
             d->enabled = false;
             return;
@@ -109,7 +110,7 @@ namespace SDDM {
         reply = xcb_xkb_get_names_reply(m_conn, cookie, &error);
 
         if (error) {
-            qCritical() << "Can't init led map: " << error->error_code;
+            qCCritical(SDDM_MODELS) << "Can't init led map: " << error->error_code;
             d->enabled = false;
             return;
         }
@@ -157,7 +158,7 @@ namespace SDDM {
 
         if (error) {
             // Log and disable
-            qCritical() << "Can't init layouts: " << error->error_code;
+            qCCritical(SDDM_MODELS) << "Can't init layouts: " << error->error_code;
             return;
         }
 
@@ -213,7 +214,7 @@ namespace SDDM {
             free(reply);
         } else {
             // Log error and disable extension
-            qCritical() << "Can't load leds state - " << error->error_code;
+            qCCritical(SDDM_MODELS) << "Can't load leds state - " << error->error_code;
             d->enabled = false;
         }
     }
@@ -234,7 +235,7 @@ namespace SDDM {
             free(reply);
         } else {
             // Log error
-            qWarning() << "Failed to get atom name: " << error->error_code;
+            qCWarning(SDDM_MODELS) << "Failed to get atom name: " << error->error_code;
         }
         return res;
     }
@@ -261,7 +262,7 @@ namespace SDDM {
             free(reply);
         } else {
             // Log error
-            qWarning() << "Can't get indicator mask " << error->error_code;
+            qCWarning(SDDM_MODELS) << "Can't get indicator mask " << error->error_code;
         }
         return mask;
     }
@@ -316,7 +317,7 @@ namespace SDDM {
         // Check errors
         error = xcb_request_check(m_conn, cookie);
         if (error) {
-            qCritical() << "Can't select xck-xkb events: " << error->error_code;
+            qCCritical(SDDM_MODELS) << "Can't select xck-xkb events: " << error->error_code;
             d->enabled = false;
             return;
         }
@@ -84,6 +84,8 @@ Rectangle {
                 focus: (listView.currentIndex === index) ? true : false
                 state: (listView.currentIndex === index) ? "active" : ""
 
+                readonly property string userName: model.name
+
                 onLogin: sddm.login(model.name, password, sessionIndex);
 
                 MouseArea {
@@ -150,6 +152,9 @@ Rectangle {
                         orientation: ListView.Horizontal
                         currentIndex: userModel.lastIndex
 
+                        // also fires once the preselected user's delegate is created
+                        onCurrentItemChanged: if (currentItem) sddm.prepareLogin(currentItem.userName)
+
                         KeyNavigation.backtab: prevUser; KeyNavigation.tab: nextUser
                     }
 
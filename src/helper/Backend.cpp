@@ -53,6 +53,10 @@ namespace SDDM {
         m_greeter = on;
     }
 
+    bool Backend::isGreeter() const {
+        return m_greeter;
+    }
+
     bool Backend::openSession() {
         struct passwd *pw;
         pw = getpwnam(qPrintable(qobject_cast<HelperApp*>(parent())->user()));
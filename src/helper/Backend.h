@@ -37,6 +37,7 @@ namespace SDDM {
 
         void setAutologin(bool on = true);
         void setGreeter(bool on = true);
+        bool isGreeter() const;
 
     public slots:
         virtual bool start(const QString &user = QString()) = 0;
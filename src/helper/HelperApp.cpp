@@ -20,8 +20,12 @@
 
 #include "HelperApp.h"
 #include "Backend.h"
+#include "Configuration.h"
+#include "LoggingCategories.h"
 #include "UserSession.h"
 #include "SafeDataStream.h"
+#include "LoginTrace.h"
+#include "Prefetcher.h"
 
 #include "MessageHandler.h"
 
@@ -31,6 +35,7 @@
 #include <QtNetwork/QLocalSocket>
 
 #include <iostream>
+#include <pwd.h>
 #include <unistd.h>
 #include <sys/socket.h>
 
@@ -39,8 +44,10 @@ namespace SDDM {
             : QCoreApplication(argc, argv)
             , m_backend(Backend::get(this))
             , m_session(new UserSession(this))
+            , m_prefetcher(new Prefetcher(this))
             , m_socket(new QLocalSocket(this)) {
         qInstallMessageHandler(HelperMessageHandler);
+        setLoggingRules(mainConfig.LoggingRules.get());
 
         QTimer::singleShot(0, this, SLOT(setUp()));
     }
@@ -48,29 +55,51 @@ namespace SDDM {
     void HelperApp::setUp() {
         QStringList args = QCoreApplication::arguments();
         QString server;
+        int socketFd = -1;
+        bool standby = false;
         int pos;
 
         if ((pos = args.indexOf(QStringLiteral("--socket"))) >= 0) {
             if (pos >= args.length() - 1) {
-                qCritical() << "This application is not supposed to be executed manually";
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
                 exit(Auth::HELPER_OTHER_ERROR);
                 return;
             }
             server = args[pos + 1];
         }
 
+        if ((pos = args.indexOf(QStringLiteral("--socket-fd"))) >= 0) {
+            bool ok = false;
+            if (pos < args.length() - 1)
+                socketFd = args[pos + 1].toInt(&ok);
+            if (!ok || socketFd < 0) {
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
+                exit(Auth::HELPER_OTHER_ERROR);
+                return;
+            }
+        }
+
         if ((pos = args.indexOf(QStringLiteral("--id"))) >= 0) {
             if (pos >= args.length() - 1) {
-                qCritical() << "This application is not supposed to be executed manually";
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
                 exit(Auth::HELPER_OTHER_ERROR);
                 return;
             }
             m_id = QString(args[pos + 1]).toLongLong();
         }
 
+        if ((pos = args.indexOf(QStringLiteral("--login-id"))) >= 0) {
+            if (pos >= args.length() - 1) {
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
+                exit(Auth::HELPER_OTHER_ERROR);
+                return;
+            }
+            m_loginId = args[pos + 1].toULongLong();
+        }
+
         if ((pos = args.indexOf(QStringLiteral("--start"))) >= 0) {
             if (pos >= args.length() - 1) {
-                qCritical() << "This application is not supposed to be executed manually";
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
                 exit(Auth::HELPER_OTHER_ERROR);
                 return;
             }
@@ -79,7 +108,7 @@ namespace SDDM {
 
         if ((pos = args.indexOf(QStringLiteral("--user"))) >= 0) {
             if (pos >= args.length() - 1) {
-                qCritical() << "This application is not supposed to be executed manually";
+                qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
                 exit(Auth::HELPER_OTHER_ERROR);
                 return;
             }
@@ -94,30 +123,87 @@ namespace SDDM {
             m_backend->setGreeter(true);
         }
 
-        if (server.isEmpty() || m_id <= 0) {
-            qCritical() << "This application is not supposed to be executed manually";
+        if ((pos = args.indexOf(QStringLiteral("--standby"))) >= 0) {
+            standby = true;
+        }
+
+        if ((socketFd < 0 && (server.isEmpty() || m_id <= 0)) || (standby && socketFd < 0)) {
+            qCCritical(SDDM_HELPER) << "This application is not supposed to be executed manually";
             exit(Auth::HELPER_OTHER_ERROR);
             return;
         }
 
-        connect(m_socket, SIGNAL(connected()), this, SLOT(doAuth()));
         connect(m_session, SIGNAL(finished(int)), this, SLOT(sessionFinished(int)));
+
+        // the daemon handed us an already connected socket, no need to introduce ourselves
+        if (socketFd >= 0) {
+            if (!m_socket->setSocketDescriptor(socketFd, QLocalSocket::ConnectedState, QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+                qCCritical(SDDM_HELPER) << "Couldn't use the socket passed by the daemon:" << m_socket->errorString();
+                exit(Auth::HELPER_OTHER_ERROR);
+                return;
+            }
+            if (standby)
+                waitForJob();
+            else
+                doAuth();
+            return;
+        }
+
+        connect(m_socket, SIGNAL(connected()), this, SLOT(doAuth()));
         m_socket->connectToServer(server, QIODevice::ReadWrite | QIODevice::Unbuffered);
     }
 
-    void HelperApp::doAuth() {
+    void HelperApp::waitForJob() {
+        Msg m = Msg::MSG_UNKNOWN;
+        QString path;
+        bool autologin = false;
+        bool greeter = false;
+
+        // we're idle in the daemon's pool until someone needs us
         SafeDataStream str(m_socket);
-        str << Msg::HELLO << m_id;
-        str.send();
-        if (str.status() != QDataStream::Ok)
-            qCritical() << "Couldn't write initial message:" << str.status();
+        str.receive();
+        str >> m >> path >> m_user >> autologin >> greeter >> m_loginId;
+        if (m != START) {
+            // the pool let us go
+            exit(Auth::HELPER_OTHER_ERROR);
+            return;
+        }
+
+        m_session->setPath(path);
+        m_backend->setAutologin(autologin);
+        m_backend->setGreeter(greeter);
+
+        doAuth();
+    }
 
+    void HelperApp::doAuth() {
+        // only through the rendezvous socket, a socket pair is ours already
+        if (m_id > 0) {
+            SafeDataStream str(m_socket);
+            str << Msg::HELLO << m_id;
+            str.send();
+            if (str.status() != QDataStream::Ok)
+                qCCritical(SDDM_HELPER) << "Couldn't write initial message:" << str.status();
+            trace(QStringLiteral("HELLO"));
+        }
+
+        trace(QStringLiteral("start"));
         if (!m_backend->start(m_user)) {
             authenticated(QString());
             exit(Auth::HELPER_AUTH_ERROR);
             return;
         }
 
+        // get NSS (sssd, LDAP...) to look the user up while the password is
+        // still being typed, the session setup needs the entry later
+        if (!m_user.isEmpty())
+            getpwnam(qPrintable(m_user));
+
+        // and the disk to read what the last session used meanwhile
+        if (!m_backend->isGreeter() && !m_session->path().isEmpty())
+            m_prefetcher->prefetch(m_user);
+
+        trace(QStringLiteral("authenticate"));
         if (!m_backend->authenticate()) {
             authenticated(QString());
             exit(Auth::HELPER_AUTH_ERROR);
@@ -128,14 +214,23 @@ namespace SDDM {
         QProcessEnvironment env = authenticated(m_user);
 
         if (!m_session->path().isEmpty()) {
+            // no-op if the user was already known before authenticating
+            if (!m_backend->isGreeter())
+                m_prefetcher->prefetch(m_user);
+
             env.insert(m_session->processEnvironment());
             m_session->setProcessEnvironment(env);
 
+            trace(QStringLiteral("openSession"));
             if (!m_backend->openSession()) {
                 sessionOpened(false);
                 exit(Auth::HELPER_SESSION_ERROR);
                 return;
             }
+            // UserSession::start() waits for the process to be running
+            trace(QStringLiteral("session"));
+
+            m_prefetcher->recordSession(m_session->processId());
 
             sessionOpened(true);
         }
@@ -149,6 +244,16 @@ namespace SDDM {
         exit(status);
     }
 
+    void HelperApp::trace(const QString &phase) {
+        if (m_loginId == 0)
+            return;
+
+        qint64 timestamp = LoginTrace::now();
+        SafeDataStream str(m_socket);
+        str << Msg::TRACE << m_loginId << phase << timestamp;
+        str.send();
+    }
+
     void HelperApp::info(const QString& message, Auth::Info type) {
         SafeDataStream str(m_socket);
         str << Msg::INFO << message << type;
@@ -173,7 +278,7 @@ namespace SDDM {
         str >> m >> response;
         if (m != REQUEST) {
             response = Request();
-            qCritical() << "Received a wrong opcode instead of REQUEST:" << m;
+            qCCritical(SDDM_HELPER) << "Received a wrong opcode instead of REQUEST:" << m;
         }
         return response;
     }
@@ -186,12 +291,16 @@ namespace SDDM {
         str.send();
         if (user.isEmpty())
             return env;
+        QString path;
         str.receive();
-        str >> m >> env >> m_cookie;
+        str >> m >> env >> m_cookie >> path;
+        // the session may have been chosen after we were started
+        if (!path.isEmpty())
+            m_session->setPath(path);
         if (m != AUTHENTICATED) {
             env = QProcessEnvironment();
             m_cookie = QString();
-            qCritical() << "Received a wrong opcode instead of AUTHENTICATED:" << m;
+            qCCritical(SDDM_HELPER) << "Received a wrong opcode instead of AUTHENTICATED:" << m;
         }
         return env;
     }
@@ -204,7 +313,7 @@ namespace SDDM {
         str.receive();
         str >> m;
         if (m != SESSION_STATUS) {
-            qCritical() << "Received a wrong opcode instead of SESSION_STATUS:" << m;
+            qCCritical(SDDM_HELPER) << "Received a wrong opcode instead of SESSION_STATUS:" << m;
         }
     }
 
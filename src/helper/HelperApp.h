@@ -30,6 +30,7 @@ class QLocalSocket;
 
 namespace SDDM {
     class Backend;
+    class Prefetcher;
     class UserSession;
     class HelperApp : public QCoreApplication
     {
@@ -51,14 +52,19 @@ namespace SDDM {
 
     private slots:
         void setUp();
+        void waitForJob();
         void doAuth();
 
         void sessionFinished(int status);
 
     private:
+        void trace(const QString &phase);
+
         qint64 m_id { -1 };
+        quint64 m_loginId { 0 };
         Backend *m_backend { nullptr };
         UserSession *m_session { nullptr };
+        Prefetcher *m_prefetcher { nullptr };
         QLocalSocket *m_socket { nullptr };
         QString m_user { };
         // TODO: get rid of this in a nice clean way along the way with moving to user session X server
@@ -0,0 +1,290 @@
+/*
+ * Page cache warm-up for the user's session
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Prefetcher.h"
+#include "Configuration.h"
+#include "Constants.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/fsuid.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// glibc's setgroups() changes every thread, the system call only the
+// calling one. The 16 bit version is the plain one where both exist.
+#ifdef SYS_setgroups32
+#define SYS_SETGROUPS SYS_setgroups32
+#else
+#define SYS_SETGROUPS SYS_setgroups
+#endif
+
+// long enough for the desktop to have come up
+#define RECORD_DELAY (30 * 1000)
+
+// way more than any desktop maps, keeps a bogus list from taking forever
+#define MAX_FILES 8192
+
+namespace SDDM {
+    // read by the shell and by Xsession before anything gets mapped
+    static const char *startupFiles[] = {
+        ".profile", ".bash_profile", ".bash_login", ".bashrc",
+        ".zshenv", ".zprofile", ".zshrc", ".zlogin",
+        ".xprofile", ".xsession", ".xsessionrc", ".Xresources", ".Xdefaults",
+        ".config/user-dirs.dirs", ".config/mimeapps.list"
+    };
+
+    class PrefetchThread : public QThread {
+    public:
+        PrefetchThread(const QStringList &files, uid_t uid, gid_t gid, const QVector<gid_t> &groups)
+            : m_files(files), m_uid(uid), m_gid(gid), m_groups(groups) { }
+
+    protected:
+        void run() override {
+            // the paths are the user's to choose, so only read what the user
+            // could. The file system ids and the groups are per thread as
+            // far as the kernel is concerned, the raw system calls leave the
+            // rest of the helper alone.
+            if (::syscall(SYS_SETGROUPS, m_groups.size(), m_groups.constData()) != 0) {
+                qCWarning(SDDM_HELPER) << "Prefetch: Failed to set the groups:" << strerror(errno);
+                return;
+            }
+            setfsgid(m_gid);
+            setfsuid(m_uid);
+            if (uid_t(setfsuid(m_uid)) != m_uid || gid_t(setfsgid(m_gid)) != m_gid) {
+                qCWarning(SDDM_HELPER) << "Prefetch: Failed to switch to the user's file system ids";
+                return;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+
+            int count = 0;
+            qint64 bytes = 0;
+            for (const QString &file : m_files) {
+                const QByteArray path = QFile::encodeName(file);
+
+                // only ever open regular files, opening a device or a fifo
+                // could have side effects or block. An O_PATH descriptor
+                // doesn't open anything, and the file checked is the one
+                // opened through it.
+                int pathFd = ::open(path.constData(), O_PATH | O_CLOEXEC);
+                if (pathFd < 0)
+                    continue;
+
+                struct stat st;
+                if (::fstat(pathFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+                    ::close(pathFd);
+                    continue;
+                }
+
+                const QByteArray fdPath = "/proc/self/fd/" + QByteArray::number(pathFd);
+                int fd = ::open(fdPath.constData(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC | O_NOATIME);
+                if (fd < 0 && errno == EPERM)
+                    fd = ::open(fdPath.constData(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+                ::close(pathFd);
+                if (fd < 0)
+                    continue;
+
+                if (::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0) {
+                    ++count;
+                    bytes += st.st_size;
+                }
+                ::close(fd);
+            }
+
+            qCDebug(SDDM_HELPER) << "Prefetch: Requested" << count << "files," << bytes / 1024 << "KiB in" << timer.elapsed() << "ms";
+        }
+
+    private:
+        QStringList m_files;
+        uid_t m_uid;
+        gid_t m_gid;
+        QVector<gid_t> m_groups;
+    };
+
+    // root owned and only accessible by root, the state directory itself
+    // belongs to the greeter user
+    static bool ensurePrivateDir(const QString &path) {
+        const QByteArray dir = QFile::encodeName(path);
+        if (::mkdir(dir.constData(), 0700) != 0 && errno != EEXIST)
+            return false;
+
+        struct stat st;
+        return ::lstat(dir.constData(), &st) == 0 && S_ISDIR(st.st_mode) &&
+               st.st_uid == 0 && (st.st_mode & 0077) == 0;
+    }
+
+    static QSet<QString> mappedFiles(qint64 pid) {
+        QSet<QString> files;
+
+        QFile maps(QStringLiteral("/proc/%1/maps").arg(pid));
+        if (!maps.open(QIODevice::ReadOnly))
+            return files;
+
+        // address perms offset dev inode path
+        for (const QByteArray &line : maps.readAll().split('\n')) {
+            int slash = line.indexOf('/');
+            if (slash < 0 || line.endsWith(" (deleted)"))
+                continue;
+            files << QFile::decodeName(line.mid(slash));
+        }
+
+        return files;
+    }
+
+    static QList<qint64> descendants(qint64 pid) {
+        // parent of every process on the system
+        QHash<qint64, QList<qint64>> children;
+        for (const QString &entry : QDir(QStringLiteral("/proc")).entryList(QDir::Dirs)) {
+            bool ok = false;
+            qint64 child = entry.toLongLong(&ok);
+            if (!ok)
+                continue;
+
+            QFile stat(QStringLiteral("/proc/%1/stat").arg(child));
+            if (!stat.open(QIODevice::ReadOnly))
+                continue;
+
+            // pid (comm) state ppid ..., comm may contain anything
+            const QByteArray line = stat.readAll();
+            const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+            if (fields.size() > 1)
+                children[fields[1].toLongLong()] << child;
+        }
+
+        QList<qint64> result { pid };
+        for (int i = 0; i < result.size(); ++i)
+            result << children.value(result[i]);
+        return result;
+    }
+
+    Prefetcher::Prefetcher(QObject *parent) : QObject(parent) {
+    }
+
+    Prefetcher::~Prefetcher() {
+        if (m_thread)
+            m_thread->wait();
+    }
+
+    QString Prefetcher::listPath() const {
+        return QStringLiteral("%1/prefetch/%2").arg(QStringLiteral(STATE_DIR)).arg(m_user);
+    }
+
+    void Prefetcher::prefetch(const QString &user) {
+        if (!mainConfig.PrefetchSession.get() || m_thread || user.isEmpty())
+            return;
+
+        struct passwd *pw = getpwnam(qPrintable(user));
+        if (!pw)
+            return;
+
+        m_user = user;
+        m_home = QFile::decodeName(pw->pw_dir);
+
+        // read as the user, with the groups the session will have
+        const uid_t uid = pw->pw_uid;
+        const gid_t gid = pw->pw_gid;
+        QVector<gid_t> groups(64);
+        int ngroups = groups.size();
+        if (getgrouplist(pw->pw_name, gid, groups.data(), &ngroups) < 0) {
+            groups.resize(ngroups);
+            if (getgrouplist(pw->pw_name, gid, groups.data(), &ngroups) < 0)
+                return;
+        }
+        groups.resize(ngroups);
+
+        QStringList files;
+        for (const char *file : startupFiles)
+            files << QStringLiteral("%1/%2").arg(m_home).arg(QLatin1String(file));
+        files << mainConfig.X11.SessionCommand.get() << mainConfig.Wayland.SessionCommand.get();
+
+        // what the last session used
+        if (ensurePrivateDir(QStringLiteral(STATE_DIR "/prefetch"))) {
+            QFile list(listPath());
+            if (list.open(QIODevice::ReadOnly)) {
+                while (!list.atEnd() && files.size() < MAX_FILES) {
+                    const QString file = QFile::decodeName(list.readLine().trimmed());
+                    if (file.startsWith(QLatin1Char('/')))
+                        files << file;
+                }
+            }
+        }
+
+        m_prefetched = files.toSet();
+
+        m_thread = new PrefetchThread(files, uid, gid, groups);
+        m_thread->setParent(this);
+        m_thread->start(QThread::LowPriority);
+    }
+
+    void Prefetcher::recordSession(qint64 pid) {
+        if (!m_thread || pid <= 0)
+            return;
+
+        m_sessionPid = pid;
+        QTimer::singleShot(RECORD_DELAY, this, SLOT(record()));
+    }
+
+    void Prefetcher::record() {
+        QSet<QString> used;
+        for (qint64 pid : descendants(m_sessionPid))
+            used += mappedFiles(pid);
+        if (used.isEmpty())
+            return;
+
+        // hits: used files we had prefetched, out of all used ones
+        const int hits = QSet<QString>(used).intersect(m_prefetched).size();
+        qCDebug(SDDM_HELPER, "Prefetch: %d of %d files used by the session were prefetched (%d%%), %d of %d prefetched files were used",
+               hits, used.size(), used.size() ? hits * 100 / used.size() : 0, hits, m_prefetched.size());
+
+        if (!ensurePrivateDir(QStringLiteral(STATE_DIR "/prefetch")))
+            return;
+
+        QStringList files = used.toList();
+        files.sort();
+        files = files.mid(0, MAX_FILES);
+
+        QSaveFile list(listPath());
+        if (!list.open(QIODevice::WriteOnly)) {
+            qCWarning(SDDM_HELPER) << "Prefetch: Failed to save" << list.fileName() << ":" << list.errorString();
+            return;
+        }
+        list.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+        for (const QString &file : files)
+            list.write(QFile::encodeName(file) + '\n');
+        list.commit();
+    }
+}
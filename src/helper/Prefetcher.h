@@ -0,0 +1,79 @@
+/*
+ * Page cache warm-up for the user's session
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_PREFETCHER_H
+#define SDDM_PREFETCHER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+
+namespace SDDM {
+    class PrefetchThread;
+
+    /**
+    * \brief
+    * Gets the files a user's session needs into the page cache early
+    *
+    * \section description
+    * Some time after a session has started, the files mapped by its
+    * processes are recorded into a per-user list in the state directory.
+    * Next time the user is known, before the password is even checked, the
+    * list is read and every file is handed to posix_fadvise(WILLNEED) from
+    * a background thread, along with the usual shell and X startup files.
+    * The thread takes the user's file system ids and groups first, so it
+    * only gets to read what the user could, and only regular files are
+    * ever opened.
+    *
+    * When recording, the new working set is compared with what was
+    * prefetched and the hit rate is logged.
+    */
+    class Prefetcher : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(Prefetcher)
+    public:
+        explicit Prefetcher(QObject *parent = nullptr);
+        ~Prefetcher();
+
+        /**
+        * Starts prefetching the working set of \a user, only once
+        */
+        void prefetch(const QString &user);
+
+        /**
+        * Records the working set of the session running as \a pid a bit later
+        */
+        void recordSession(qint64 pid);
+
+    private slots:
+        void record();
+
+    private:
+        QString listPath() const;
+
+        PrefetchThread *m_thread { nullptr };
+        QString m_user { };
+        QString m_home { };
+        QSet<QString> m_prefetched { };
+        qint64 m_sessionPid { 0 };
+    };
+}
+
+#endif // SDDM_PREFETCHER_H
@@ -0,0 +1,176 @@
+/*
+ * Size-capped, rotating log of the user's session
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SessionLog.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QVector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+namespace SDDM {
+    SessionLog::SessionLog(const QString &path, qint64 maxSize, int keep)
+        : m_path(QFile::encodeName(path))
+        , m_maxSize(maxSize) {
+        for (int i = 1; i <= keep; ++i)
+            m_rotated << m_path + '.' + QByteArray::number(i);
+    }
+
+    int SessionLog::start() {
+        // keep the last session's log around, its writer may still be
+        // running and about to rotate it as well
+        int previous = ::open(m_path.constData(), O_RDONLY | O_CLOEXEC);
+        if (previous >= 0)
+            ::flock(previous, LOCK_EX);
+        rotate();
+        int output = open(true);
+        if (previous >= 0)
+            ::close(previous);
+        if (output < 0 || m_maxSize <= 0)
+            return output;
+
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) < 0)
+            return output;
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // hand the writer over to init rather than to the session
+            pid_t writer = fork();
+            if (writer != 0)
+                _exit(writer < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+
+            setsid();
+            run(fds[0], output);
+        }
+
+        int status = EXIT_FAILURE;
+        if (pid > 0) {
+            while (waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+        }
+        ::close(fds[0]);
+
+        // without a writer the session writes to the log directly
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            ::close(fds[1]);
+            return output;
+        }
+
+        ::close(output);
+        return fds[1];
+    }
+
+    void SessionLog::rotate() const {
+        // the oldest goes, the others move down one
+        if (!m_rotated.isEmpty())
+            ::unlink(m_rotated.last().constData());
+        for (int i = m_rotated.size() - 1; i > 0; --i)
+            ::rename(m_rotated.at(i - 1).constData(), m_rotated.at(i).constData());
+        if (!m_rotated.isEmpty())
+            ::rename(m_path.constData(), m_rotated.first().constData());
+    }
+
+    int SessionLog::open(bool truncate) const {
+        // appending, as writers of several sessions may share the log
+        return ::open(m_path.constData(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0600);
+    }
+
+    int SessionLog::reopen(int output) const {
+        // another writer may share the log, whoever gets the lock first
+        // rotates it and the others carry on in the new one. The lock is
+        // only released once the new log exists.
+        if (output >= 0)
+            ::flock(output, LOCK_EX);
+
+        struct stat ours, current;
+        const bool rotated = output >= 0 && ::fstat(output, &ours) == 0 &&
+                             (::stat(m_path.constData(), &current) != 0 ||
+                              ours.st_dev != current.st_dev || ours.st_ino != current.st_ino);
+
+        if (!rotated)
+            rotate();
+        const int next = open(!rotated);
+
+        if (output >= 0)
+            ::close(output);
+
+        return next;
+    }
+
+    void SessionLog::run(int input, int output) const {
+        // don't keep anything else of the session's open, its sockets
+        // and pipes would otherwise outlive it
+        QVector<int> fds;
+        if (DIR *dir = opendir("/proc/self/fd")) {
+            while (struct dirent *entry = readdir(dir)) {
+                const int fd = atoi(entry->d_name);
+                if (entry->d_name[0] != '.' && fd != dirfd(dir) && fd != input && fd != output)
+                    fds << fd;
+            }
+            closedir(dir);
+        }
+        for (int fd : fds)
+            ::close(fd);
+
+        char buffer[16384];
+
+        forever {
+            const ssize_t count = ::read(input, buffer, sizeof(buffer));
+            if (count == 0)
+                break;
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+
+            // the size of the file rather than what went through here,
+            // the writer of another session may append to it too
+            struct stat st;
+            const qint64 size = output >= 0 && ::fstat(output, &st) == 0 ? st.st_size : 0;
+            if (size > 0 && size + count > m_maxSize)
+                output = reopen(output);
+
+            // keep reading even if the log can't be written, the session
+            // would otherwise block on a full pipe
+            const char *p = buffer;
+            ssize_t left = count;
+            while (output >= 0 && left > 0) {
+                const ssize_t written = ::write(output, p, left);
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+                p += written;
+                left -= written;
+            }
+        }
+
+        _exit(EXIT_SUCCESS);
+    }
+}
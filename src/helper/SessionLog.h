@@ -0,0 +1,79 @@
+/*
+ * Size-capped, rotating log of the user's session
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SDDM_SESSIONLOG_H
+#define SDDM_SESSIONLOG_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Where the session's stderr goes
+    *
+    * \section description
+    * The log of the last session is moved aside to "<path>.1", the one
+    * before to "<path>.2" and so on, only the \a keep most recent ones are
+    * kept.
+    *
+    * With a size cap, the session writes to a pipe and a process of its
+    * own copies what comes through to the log, rotating it the same way
+    * whenever it grows past the cap, so a chatty client can take at most
+    * the cap times the number of logs kept. The writer is detached from
+    * the session and lives until the last process holding the pipe exits.
+    * A writer which outlived its session shares the log with the next
+    * one's: rotating is serialized with flock() on the log, and a writer
+    * finding the log rotated by the other just carries on in the new one.
+    *
+    * Meant to be used in the session's process once it runs as the user,
+    * so the logs are the user's and nothing is written to the home
+    * directory with more rights than the user has.
+    */
+    class SessionLog {
+        Q_DISABLE_COPY(SessionLog)
+    public:
+        /**
+        * @param maxSize size in bytes after which the log is rotated,
+        *                0 for no limit
+        * @param keep number of rotated logs to keep
+        */
+        SessionLog(const QString &path, qint64 maxSize, int keep);
+
+        /**
+        * Rotates the logs of the previous sessions and starts the writer
+        * @return the file descriptor to write the log to, -1 on failure
+        */
+        int start();
+
+    private:
+        void rotate() const;
+        int open(bool truncate) const;
+        int reopen(int output) const;
+        void run(int input, int output) const;
+
+        QByteArray m_path;
+        QList<QByteArray> m_rotated;
+        qint64 m_maxSize { 0 };
+    };
+}
+
+#endif // SDDM_SESSIONLOG_H
@@ -22,6 +22,9 @@
 #include "Configuration.h"
 #include "UserSession.h"
 #include "HelperApp.h"
+#include "LoggingCategories.h"
+#include "SessionLog.h"
+#include "XAuth.h"
 
 #include <sys/types.h>
 #include <sys/ioctl.h>
@@ -33,9 +36,6 @@
 #include <unistd.h>
 #include <fcntl.h>
 
-#include <X11/Xauth.h>
-
-
 namespace SDDM {
     UserSession::UserSession(HelperApp *parent)
             : QProcess(parent) {
@@ -52,14 +52,14 @@ namespace SDDM {
             QProcess::start(m_path);
         } else if (env.value(QStringLiteral("XDG_SESSION_TYPE")) == QLatin1String("x11")) {
             const QString cmd = QStringLiteral("%1 \"%2\"").arg(mainConfig.X11.SessionCommand.get()).arg(m_path);
-            qInfo() << "Starting:" << cmd;
+            qCInfo(SDDM_HELPER) << "Starting:" << cmd;
             QProcess::start(cmd);
         } else if (env.value(QStringLiteral("XDG_SESSION_TYPE")) == QLatin1String("wayland")) {
             const QString cmd = QStringLiteral("%1 %2").arg(mainConfig.Wayland.SessionCommand.get()).arg(m_path);
-            qInfo() << "Starting:" << cmd;
+            qCInfo(SDDM_HELPER) << "Starting:" << cmd;
             QProcess::start(cmd);
         } else {
-            qCritical() << "Unable to run user session: unknown session type";
+            qCCritical(SDDM_HELPER) << "Unable to run user session: unknown session type";
         }
 
         return waitForStarted();
@@ -99,7 +99,7 @@ namespace SDDM {
 
             // set this process as session leader
             if (setsid() < 0) {
-                qCritical("Failed to set pid %lld as leader of the new session and process group: %s",
+                qCCritical(SDDM_HELPER, "Failed to set pid %lld as leader of the new session and process group: %s",
                           QCoreApplication::applicationPid(), strerror(errno));
                 exit(Auth::HELPER_OTHER_ERROR);
             }
@@ -107,7 +107,7 @@ namespace SDDM {
             // take control of the tty
             if (takeControl) {
                 if (ioctl(STDIN_FILENO, TIOCSCTTY) < 0) {
-                    qCritical("Failed to take control of the tty: %s", strerror(errno));
+                    qCCritical(SDDM_HELPER, "Failed to take control of the tty: %s", strerror(errno));
                     exit(Auth::HELPER_OTHER_ERROR);
                 }
             }
@@ -116,20 +116,20 @@ namespace SDDM {
         const QByteArray username = qobject_cast<HelperApp*>(parent())->user().toLocal8Bit();
         struct passwd *pw = getpwnam(username.constData());
         if (setgid(pw->pw_gid) != 0) {
-            qCritical() << "setgid(" << pw->pw_gid << ") failed for user: " << username;
+            qCCritical(SDDM_HELPER) << "setgid(" << pw->pw_gid << ") failed for user: " << username;
             exit(Auth::HELPER_OTHER_ERROR);
         }
         if (initgroups(pw->pw_name, pw->pw_gid) != 0) {
-            qCritical() << "initgroups(" << pw->pw_name << ", " << pw->pw_gid << ") failed for user: " << username;
+            qCCritical(SDDM_HELPER) << "initgroups(" << pw->pw_name << ", " << pw->pw_gid << ") failed for user: " << username;
             exit(Auth::HELPER_OTHER_ERROR);
         }
         if (setuid(pw->pw_uid) != 0) {
-            qCritical() << "setuid(" << pw->pw_uid << ") failed for user: " << username;
+            qCCritical(SDDM_HELPER) << "setuid(" << pw->pw_uid << ") failed for user: " << username;
             exit(Auth::HELPER_OTHER_ERROR);
         }
         if (chdir(pw->pw_dir) != 0) {
-            qCritical() << "chdir(" << pw->pw_dir << ") failed for user: " << username;
-            qCritical() << "verify directory exist and has sufficient permissions";
+            qCCritical(SDDM_HELPER) << "chdir(" << pw->pw_dir << ") failed for user: " << username;
+            qCCritical(SDDM_HELPER) << "verify directory exist and has sufficient permissions";
             exit(Auth::HELPER_OTHER_ERROR);
         }
 
@@ -147,14 +147,15 @@ namespace SDDM {
         QFileInfo finfo(sessionLog);
         QDir().mkpath(finfo.absolutePath());
 
-        //swap the stderr pipe of this subprcess into a file
-        int fd = ::open(qPrintable(sessionLog), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        //swap the stderr pipe of this subprcess into the log, rotated and size capped
+        SessionLog log(sessionLog, qint64(mainConfig.SessionLogMaxSize.get()) * 1024, mainConfig.SessionLogKeep.get());
+        int fd = log.start();
         if (fd >= 0)
         {
             dup2 (fd, STDERR_FILENO);
             ::close(fd);
         } else {
-            qWarning() << "Could not open stderr to" << sessionLog;
+            qCWarning(SDDM_HELPER) << "Could not open stderr to" << sessionLog;
         }
 
         //redirect any stdout to /dev/null
@@ -164,7 +165,7 @@ namespace SDDM {
             dup2 (fd, STDOUT_FILENO);
             ::close(fd);
         } else {
-            qWarning() << "Could not redirect stdout";
+            qCWarning(SDDM_HELPER) << "Could not redirect stdout";
         }
 
         // set X authority for X11 sessions only
@@ -173,53 +174,15 @@ namespace SDDM {
         QString cookie = qobject_cast<HelperApp*>(parent())->cookie();
         if (!cookie.isEmpty()) {
             QString file = processEnvironment().value(QStringLiteral("XAUTHORITY"));
-            Xauth auth = { 0 };
-            char localhost[HOST_NAME_MAX + 1] = { 0 };
-
-            qDebug() << "Adding cookie to" << file;
-
-            if (gethostname(localhost, HOST_NAME_MAX) < 0) {
-                strcpy(localhost, "localhost");
-            }
-
-            // libXau expects binary data, not a string
-            QByteArray cookieBinary = QByteArray::fromHex(cookie.toLatin1());
 
-            // set up the auth entry
-            char cookieName[] = "MIT-MAGIC-COOKIE-1";
-            auth.family = FamilyLocal;
-            auth.address = localhost;
-            auth.address_length = strlen(auth.address);
-            auth.name = cookieName;
-            auth.name_length = sizeof(cookieName);
-            auth.data_length = cookieBinary.count();
-            auth.data = cookieBinary.data();
+            qCDebug(SDDM_HELPER) << "Adding cookie to" << file;
 
             // create the path
             QFileInfo finfo(file);
             QDir().mkpath(finfo.absolutePath());
 
-            // open the file
-            FILE *fp = fopen(qPrintable(file), "w");
-            if (!fp)
-                qWarning() << "Opening the Xauthority file at" << file << "failed";
-
-            // write the Xauth data
-            if (!XauWriteAuth (fp, &auth) || fflush (fp) == EOF) {
-                qCritical() << "Writing the FamilyLocal information to" << file << "failed";
-                fclose(fp);
-                return;
-            }
-
-            auth.family = FamilyWild;
-
-            if (!XauWriteAuth (fp, &auth) || fflush (fp) == EOF) {
-                qCritical() << "Writing the FamilyWild information to" << file << "failed";
-                fclose(fp);
-                return;
-            }
-
-            fclose(fp);
+            // valid for any display, like before
+            XAuth::addCookie(file, QString(), cookie);
         }
     }
 }
@@ -19,7 +19,10 @@
  */
 
 #include "PamBackend.h"
+#include "LoggingCategories.h"
 #include "PamHandle.h"
+#include "PromptClassifier.h"
+#include "Configuration.h"
 #include "HelperApp.h"
 #include "UserSession.h"
 #include "Auth.h"
@@ -53,47 +56,34 @@ namespace SDDM {
 
     static Prompt invalidPrompt {};
 
-    PamData::PamData() { }
-
-    AuthPrompt::Type PamData::detectPrompt(const struct pam_message* msg) const {
-        if (msg->msg_style == PAM_PROMPT_ECHO_OFF) {
-            QString message = QString::fromLocal8Bit(msg->msg);
-            if (message.indexOf(QRegExp(QStringLiteral("\\bpassword\\b"), Qt::CaseInsensitive)) >= 0) {
-                if (message.indexOf(QRegExp(QStringLiteral("\\b(re-?(enter|type)|again|confirm|repeat)\\b"), Qt::CaseInsensitive)) >= 0) {
-                    return AuthPrompt::CHANGE_REPEAT;
-                }
-                else if (message.indexOf(QRegExp(QStringLiteral("\\bnew\\b"), Qt::CaseInsensitive)) >= 0) {
-                    return AuthPrompt::CHANGE_NEW;
-                }
-                else if (message.indexOf(QRegExp(QStringLiteral("\\b(old|current)\\b"), Qt::CaseInsensitive)) >= 0) {
-                    return AuthPrompt::CHANGE_CURRENT;
-                }
-                else {
-                    return AuthPrompt::LOGIN_PASSWORD;
-                }
-            }
+    // compiled once per helper, before the first conversation
+    static const PromptClassifier &promptClassifier() {
+        static PromptClassifier *classifier = nullptr;
+        if (!classifier) {
+            PromptClassifier::Patterns patterns = PromptClassifier::defaultPatterns();
+            if (!mainConfig.PamPrompts.Password.get().isEmpty())
+                patterns.password << mainConfig.PamPrompts.Password.get();
+            if (!mainConfig.PamPrompts.CurrentPassword.get().isEmpty())
+                patterns.current << mainConfig.PamPrompts.CurrentPassword.get();
+            if (!mainConfig.PamPrompts.NewPassword.get().isEmpty())
+                patterns.newPassword << mainConfig.PamPrompts.NewPassword.get();
+            if (!mainConfig.PamPrompts.RepeatPassword.get().isEmpty())
+                patterns.repeat << mainConfig.PamPrompts.RepeatPassword.get();
+            if (!mainConfig.PamPrompts.PasswordChange.get().isEmpty())
+                patterns.passwordChange << mainConfig.PamPrompts.PasswordChange.get();
+            classifier = new PromptClassifier(patterns);
         }
-        else {
-            return AuthPrompt::LOGIN_USER;
-        }
-
-        return AuthPrompt::UNKNOWN;
+        return *classifier;
     }
 
-    const Prompt& PamData::findPrompt(const struct pam_message* msg) const {
-        AuthPrompt::Type type = detectPrompt(msg);
+    PamData::PamData()
+            : m_classifier(promptClassifier()) { }
 
-        for (const Prompt &p : m_currentRequest.prompts) {
-            if (type == p.type && p.message == QString::fromLocal8Bit(msg->msg))
-                return p;
-        }
-
-        return invalidPrompt;
+    AuthPrompt::Type PamData::detectPrompt(const struct pam_message* msg) const {
+        return m_classifier.classifyPrompt(QString::fromLocal8Bit(msg->msg), msg->msg_style == PAM_PROMPT_ECHO_OFF);
     }
 
-    Prompt& PamData::findPrompt(const struct pam_message* msg) {
-        AuthPrompt::Type type = detectPrompt(msg);
-
+    Prompt& PamData::findPrompt(const struct pam_message* msg, AuthPrompt::Type type) {
         for (Prompt &p : m_currentRequest.prompts) {
             if (type == AuthPrompt::UNKNOWN && QString::fromLocal8Bit(msg->msg) == p.message)
                 return p;
@@ -108,7 +98,8 @@ namespace SDDM {
     * Expects an empty prompt list if the previous request has been processed
     */
     bool PamData::insertPrompt(const struct pam_message* msg, bool predict) {
-        Prompt &p = findPrompt(msg);
+        AuthPrompt::Type type = detectPrompt(msg);
+        Prompt &p = findPrompt(msg, type);
 
         // first, check if we already have stored this propmpt
         if (p.valid()) {
@@ -130,7 +121,6 @@ namespace SDDM {
 
         // we'll predict what will come next
         if (predict) {
-            AuthPrompt::Type type = detectPrompt(msg);
             switch (type) {
                 case AuthPrompt::LOGIN_USER:
                     m_currentRequest = Request(loginRequest);
@@ -147,13 +137,13 @@ namespace SDDM {
         }
 
         // or just add whatever comes exactly as it comes
-        m_currentRequest.prompts.append(Prompt(detectPrompt(msg), QString::fromLocal8Bit(msg->msg), msg->msg_style == PAM_PROMPT_ECHO_OFF));
+        m_currentRequest.prompts.append(Prompt(type, QString::fromLocal8Bit(msg->msg), msg->msg_style == PAM_PROMPT_ECHO_OFF));
 
         return true;
     }
 
     Auth::Info PamData::handleInfo(const struct pam_message* msg, bool predict) {
-        if (QString::fromLocal8Bit(msg->msg).indexOf(QRegExp(QStringLiteral("^Changing password for [^ ]+$")))) {
+        if (m_classifier.isPasswordChange(QString::fromLocal8Bit(msg->msg))) {
             if (predict)
                 m_currentRequest = Request(changePassRequest);
             return Auth::INFO_PASS_CHANGE_REQUIRED;
@@ -165,8 +155,9 @@ namespace SDDM {
     * Destroys the prompt with that response
     */
     QByteArray PamData::getResponse(const struct pam_message* msg) {
-        QByteArray response = findPrompt(msg).response;
-        m_currentRequest.prompts.removeOne(findPrompt(msg));
+        Prompt &p = findPrompt(msg, detectPrompt(msg));
+        QByteArray response = p.response;
+        m_currentRequest.prompts.removeOne(p);
         if (m_currentRequest.prompts.length() == 0)
             m_sent = false;
         return response;
@@ -181,7 +172,7 @@ namespace SDDM {
 
     void PamData::completeRequest(const Request& request) {
         if (request.prompts.length() != m_currentRequest.prompts.length()) {
-            qWarning() << "[PAM] Different request/response list length, ignoring";
+            qCWarning(SDDM_PAM) << "[PAM] Different request/response list length, ignoring";
             return;
         }
 
@@ -189,7 +180,7 @@ namespace SDDM {
             if (request.prompts[i].type != m_currentRequest.prompts[i].type
                 || request.prompts[i].message != m_currentRequest.prompts[i].message
                 || request.prompts[i].hidden != m_currentRequest.prompts[i].hidden) {
-                qWarning() << "[PAM] Order or type of the messages doesn't match, ignoring";
+                qCWarning(SDDM_PAM) << "[PAM] Order or type of the messages doesn't match, ignoring";
                 return;
             }
         }
@@ -258,7 +249,8 @@ namespace SDDM {
 #endif
                 m_pam->setItem(PAM_TTY, qPrintable(display));
             }
-        } else if (sessionEnv.value(QStringLiteral("XDG_SESSION_TYPE")) == QLatin1String("wayland")) {
+        } else if (sessionEnv.value(QStringLiteral("XDG_SESSION_TYPE")) == QLatin1String("wayland") &&
+                   sessionEnv.contains(QStringLiteral("XDG_VTNR"))) {
             QString tty = QStringLiteral("/dev/tty%1").arg(sessionEnv.value(QStringLiteral("XDG_VTNR")));
             m_pam->setItem(PAM_TTY, qPrintable(tty));
         }
@@ -278,12 +270,12 @@ namespace SDDM {
 
     bool PamBackend::closeSession() {
         if (m_pam->isOpen()) {
-            qDebug() << "[PAM] Closing session";
+            qCDebug(SDDM_PAM) << "[PAM] Closing session";
             m_pam->closeSession();
             m_pam->setCred(PAM_DELETE_CRED);
             return true;
         }
-        qWarning() << "[PAM] Asked to close the session but it wasn't previously open";
+        qCWarning(SDDM_PAM) << "[PAM] Asked to close the session but it wasn't previously open";
         return Backend::closeSession();
     }
 
@@ -292,7 +284,7 @@ namespace SDDM {
     }
 
     int PamBackend::converse(int n, const struct pam_message **msg, struct pam_response **resp) {
-        qDebug() << "[PAM] Conversation with" << n << "messages";
+        qCDebug(SDDM_PAM) << "[PAM] Conversation with" << n << "messages";
 
         bool newRequest = false;
 
@@ -32,6 +32,7 @@
 namespace SDDM {
     class PamHandle;
     class PamBackend;
+    class PromptClassifier;
     class PamData {
     public:
         PamData();
@@ -47,9 +48,9 @@ namespace SDDM {
     private:
         AuthPrompt::Type detectPrompt(const struct pam_message *msg) const;
 
-        const Prompt& findPrompt(const struct pam_message *msg) const;
-        Prompt& findPrompt(const struct pam_message *msg);
+        Prompt& findPrompt(const struct pam_message *msg, AuthPrompt::Type type);
 
+        const PromptClassifier &m_classifier;
         bool m_sent { false };
         Request m_currentRequest { };
     };
@@ -22,6 +22,7 @@
 
 #include "AuthMessages.h"
 #include "HelperApp.h"
+#include "LoggingCategories.h"
 
 #include <QtCore/QDebug>
 
@@ -74,7 +75,7 @@ namespace SDDM {
 
         struct spwd *spw = getspnam(pw->pw_name);
         if (!spw) {
-            qWarning() << "[Passwd] Could get passwd but not shadow";
+            qCWarning(SDDM_PAM) << "[Passwd] Could get passwd but not shadow";
             return false;
         }
 
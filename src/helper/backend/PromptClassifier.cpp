@@ -0,0 +1,136 @@
+/*
+ * PAM message classification
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PromptClassifier.h"
+#include "LoggingCategories.h"
+
+#include <QtCore/QDebug>
+
+namespace SDDM {
+    static const char *groupNames[] = { "password", "current", "new", "repeat" };
+
+    static QString alternatives(const QStringList &patterns) {
+        QStringList wrapped;
+        for (const QString &pattern : patterns)
+            wrapped << QStringLiteral("(?:%1)").arg(pattern);
+        return wrapped.join(QLatin1Char('|'));
+    }
+
+    PromptClassifier::Patterns PromptClassifier::defaultPatterns() {
+        Patterns p;
+
+        // English: pam_unix, pam_sss, pam_krb5 and most others
+        p.password << QStringLiteral("password");
+        p.current << QStringLiteral("old") << QStringLiteral("current");
+        p.newPassword << QStringLiteral("new");
+        p.repeat << QStringLiteral("re-?(?:enter|type)") << QStringLiteral("again")
+                 << QStringLiteral("confirm") << QStringLiteral("repeat");
+        p.passwordChange << QStringLiteral("^Changing password for \\S+$")
+                         << QStringLiteral("\\bpassword expired\\b");
+
+        // German
+        p.password << QStringLiteral("passwort") << QStringLiteral("kennwort");
+        p.current << QStringLiteral("aktuelles") << QStringLiteral("altes");
+        p.newPassword << QStringLiteral("neue[sn]?");
+        p.repeat << QStringLiteral("erneut") << QStringLiteral("wiederholen") << QStringLiteral("bestätigen");
+
+        // French
+        p.password << QStringLiteral("mot de passe");
+        p.current << QStringLiteral("actuel") << QStringLiteral("ancien");
+        p.newPassword << QStringLiteral("nouveau");
+        p.repeat << QStringLiteral("retapez") << QStringLiteral("confirmez") << QStringLiteral("encore");
+
+        // Spanish
+        p.password << QStringLiteral("contraseña");
+        p.current << QStringLiteral("actual") << QStringLiteral("antigua");
+        p.newPassword << QStringLiteral("nueva");
+        p.repeat << QStringLiteral("vuelva a escribir") << QStringLiteral("repita") << QStringLiteral("confirme");
+
+        return p;
+    }
+
+    PromptClassifier::PromptClassifier(const Patterns &patterns) {
+        compile(patterns);
+
+        // don't let a broken custom pattern take the built-in ones down with it
+        if (!m_prompt.isValid() || !m_passwordChange.isValid()) {
+            qCWarning(SDDM_PAM) << "[PAM] Invalid prompt pattern:"
+                       << (m_prompt.isValid() ? m_passwordChange.errorString() : m_prompt.errorString())
+                       << ", using the default ones";
+            compile(defaultPatterns());
+        }
+    }
+
+    void PromptClassifier::compile(const Patterns &patterns) {
+        const QStringList *keywords[_KEYWORD_LAST] = {
+            &patterns.password, &patterns.current, &patterns.newPassword, &patterns.repeat
+        };
+
+        // one named group per kind of keyword, whole words only
+        QStringList groups;
+        for (int i = 0; i < _KEYWORD_LAST; ++i) {
+            if (!keywords[i]->isEmpty())
+                groups << QStringLiteral("(?<%1>\\b(?:%2)\\b)").arg(QLatin1String(groupNames[i])).arg(alternatives(*keywords[i]));
+        }
+
+        const QRegularExpression::PatternOptions options =
+                QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption;
+
+        m_prompt = QRegularExpression(groups.join(QLatin1Char('|')), options);
+        m_prompt.optimize();
+
+        // group numbers, so that matches don't have to look names up
+        const QStringList names = m_prompt.namedCaptureGroups();
+        for (int i = 0; i < _KEYWORD_LAST; ++i)
+            m_groups[i] = names.indexOf(QLatin1String(groupNames[i]));
+
+        m_passwordChange = QRegularExpression(alternatives(patterns.passwordChange), options);
+        m_passwordChange.optimize();
+    }
+
+    AuthPrompt::Type PromptClassifier::classifyPrompt(const QString &message, bool hidden) const {
+        if (!hidden)
+            return AuthPrompt::LOGIN_USER;
+
+        bool found[_KEYWORD_LAST] = { };
+        QRegularExpressionMatchIterator it = m_prompt.globalMatch(message);
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            for (int i = 0; i < _KEYWORD_LAST; ++i) {
+                if (m_groups[i] > 0 && match.capturedStart(m_groups[i]) >= 0)
+                    found[i] = true;
+            }
+        }
+
+        if (!found[PASSWORD])
+            return AuthPrompt::UNKNOWN;
+        if (found[REPEAT])
+            return AuthPrompt::CHANGE_REPEAT;
+        if (found[NEW])
+            return AuthPrompt::CHANGE_NEW;
+        if (found[CURRENT])
+            return AuthPrompt::CHANGE_CURRENT;
+        return AuthPrompt::LOGIN_PASSWORD;
+    }
+
+    bool PromptClassifier::isPasswordChange(const QString &message) const {
+        return !m_passwordChange.pattern().isEmpty() && m_passwordChange.match(message).hasMatch();
+    }
+}
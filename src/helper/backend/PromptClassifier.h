@@ -0,0 +1,91 @@
+/*
+ * PAM message classification
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROMPTCLASSIFIER_H
+#define PROMPTCLASSIFIER_H
+
+#include "AuthPrompt.h"
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QStringList>
+
+namespace SDDM {
+    /**
+    * \brief
+    * Tells what a PAM module is asking for from the text of its message
+    *
+    * \section description
+    * PAM doesn't say whether a prompt wants the login password or the new
+    * one during a password change, so the message has to be read. Each kind
+    * of keyword is a set of regular expressions, all of them are compiled
+    * into a single expression up front and a message is classified with one
+    * scan over it.
+    *
+    * The built-in keywords cover the messages of the common modules in a
+    * few languages, more can be added through \ref Patterns.
+    */
+    class PromptClassifier {
+    public:
+        struct Patterns {
+            QStringList password { };        ///< the message is about a password at all
+            QStringList current { };         ///< ... the one in use now
+            QStringList newPassword { };     ///< ... a new one
+            QStringList repeat { };          ///< ... the new one again
+            QStringList passwordChange { };  ///< info message announcing a password change
+        };
+
+        /**
+        * Keywords understood out of the box
+        */
+        static Patterns defaultPatterns();
+
+        explicit PromptClassifier(const Patterns &patterns = defaultPatterns());
+
+        /**
+        * @param message text of the prompt
+        * @param hidden true for PAM_PROMPT_ECHO_OFF prompts
+        * @return what the prompt asks for, UNKNOWN if it can't be told
+        */
+        AuthPrompt::Type classifyPrompt(const QString &message, bool hidden) const;
+
+        /**
+        * @param message text of a PAM_TEXT_INFO message
+        * @return true if it announces that the password is about to be changed
+        */
+        bool isPasswordChange(const QString &message) const;
+
+    private:
+        enum Keyword {
+            PASSWORD = 0,
+            CURRENT,
+            NEW,
+            REPEAT,
+            _KEYWORD_LAST
+        };
+
+        void compile(const Patterns &patterns);
+
+        QRegularExpression m_prompt { };
+        QRegularExpression m_passwordChange { };
+        int m_groups[_KEYWORD_LAST] { };
+    };
+}
+
+#endif // PROMPTCLASSIFIER_H
@@ -0,0 +1,262 @@
+/*
+ * Authentication pipeline tests against a mock PAM stack
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AuthTest.h"
+#include "Auth.h"
+#include "HelperPool.h"
+
+#include <QtTest/QtTest>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+
+using namespace SDDM;
+
+QTEST_MAIN(AuthTest);
+
+// the helper gets the mock instead of libpam through a wrapper script,
+// Auth doesn't pass our environment on. It also counts the helpers started.
+void AuthTest::initTestCase() {
+    QVERIFY(m_dir.isValid());
+
+    QFile wrapper(m_dir.path() + QStringLiteral("/sddm-helper"));
+    QVERIFY(wrapper.open(QIODevice::WriteOnly));
+    wrapper.write(QStringLiteral("#!/bin/sh\n"
+                                 "export LD_PRELOAD=\"%1\"\n"
+                                 "export SDDM_MOCK_PAM_SCRIPT=\"%2/script\"\n"
+                                 "echo >> \"%2/spawned\"\n"
+                                 "exec \"%3\" \"$@\"\n")
+                  .arg(QStringLiteral(MOCKPAM_LIBRARY))
+                  .arg(m_dir.path())
+                  .arg(QStringLiteral(SDDM_HELPER)).toLocal8Bit());
+    wrapper.close();
+    QVERIFY(wrapper.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner));
+
+    HelperPool::setHelperPath(wrapper.fileName());
+}
+
+int AuthTest::spawned() const {
+    QFile file(m_dir.path() + QStringLiteral("/spawned"));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    return file.readAll().count('\n');
+}
+
+AuthTest::Result AuthTest::login(const QString &script, const QString &user,
+                                 const QString &password, const QString &newPassword,
+                                 HelperPool *pool) {
+    Result result;
+
+    QFile file(m_dir.path() + QStringLiteral("/script"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return result;
+    file.write(script.toUtf8());
+    file.close();
+
+    Auth auth(user);
+    QEventLoop loop;
+
+    // pooled helpers are only claimed by verbose ones
+    if (pool) {
+        auth.setVerbose(true);
+        auth.setHelperPool(pool);
+    }
+
+    // answer like Display does
+    connect(&auth, &Auth::requestChanged, [&]() {
+        QList<AuthPrompt *> prompts = auth.request()->prompts();
+        if (prompts.isEmpty())
+            return;
+        if (result.spawnedAtRequest < 0)
+            result.spawnedAtRequest = spawned();
+        for (AuthPrompt *prompt : prompts) {
+            switch (prompt->type()) {
+                case AuthPrompt::LOGIN_USER:
+                    prompt->setResponse(user.isEmpty() ? QByteArrayLiteral("alice") : user.toLocal8Bit());
+                    break;
+                case AuthPrompt::CHANGE_NEW:
+                case AuthPrompt::CHANGE_REPEAT:
+                    prompt->setResponse(newPassword.toLocal8Bit());
+                    break;
+                default:
+                    prompt->setResponse(password.toLocal8Bit());
+                    break;
+            }
+        }
+        auth.request()->done();
+    });
+    connect(&auth, &Auth::authentication, [&](const QString &user, bool success) {
+        result.user = user;
+        result.authenticated = success;
+    });
+    connect(&auth, &Auth::info, [&](const QString &message, Auth::Info) {
+        result.infos << message;
+    });
+    connect(&auth, &Auth::error, [&](const QString &message, Auth::Error) {
+        result.errors << message;
+    });
+    connect(&auth, &Auth::finished, [&](Auth::HelperExitStatus status) {
+        result.status = status;
+        loop.quit();
+    });
+    QTimer::singleShot(10000, &loop, SLOT(quit()));
+
+    QElapsedTimer timer;
+    timer.start();
+    auth.start();
+    if (pool)
+        result.idleAfterStart = pool->idle();
+    loop.exec();
+    result.elapsed = timer.elapsed();
+
+    return result;
+}
+
+void AuthTest::Conversation_data() {
+    QTest::addColumn<QString>("script");
+    QTest::addColumn<QString>("user");
+    QTest::addColumn<bool>("authenticated");
+    QTest::addColumn<int>("status");
+    QTest::addColumn<QStringList>("infos");
+    QTest::addColumn<QStringList>("errors");
+    QTest::addColumn<int>("minimumTime");
+
+    QTest::newRow("password")
+        << QStringLiteral("authenticate\techo-off\tPassword: \tsecret\n")
+        << QStringLiteral("alice") << true << int(Auth::HELPER_SUCCESS)
+        << QStringList() << QStringList() << 0;
+
+    QTest::newRow("wrong password")
+        << QStringLiteral("authenticate\techo-off\tPassword: \twrong\n")
+        << QStringLiteral("alice") << false << int(Auth::HELPER_AUTH_ERROR)
+        << QStringList() << QStringList { QStringLiteral("PAM_AUTH_ERR") } << 0;
+
+    QTest::newRow("user and password")
+        << QStringLiteral("authenticate\techo-on\tlogin:\talice\n"
+                          "authenticate\techo-off\tPassword: \tsecret\n")
+        << QString() << true << int(Auth::HELPER_SUCCESS)
+        << QStringList() << QStringList() << 0;
+
+    QTest::newRow("password change")
+        << QStringLiteral("authenticate\techo-off\tPassword: \tsecret\n"
+                          "acct_mgmt\tresult\tPAM_NEW_AUTHTOK_REQD\n"
+                          "chauthtok\tinfo\tChanging password for alice.\n"
+                          "chauthtok\techo-off\t(current) UNIX password: \tsecret\n"
+                          "chauthtok\techo-off\tNew password: \tbetter\n"
+                          "chauthtok\techo-off\tRetype new password: \tbetter\n")
+        << QStringLiteral("alice") << true << int(Auth::HELPER_SUCCESS)
+        << QStringList { QStringLiteral("Changing password for alice.") } << QStringList() << 0;
+
+    QTest::newRow("messages")
+        << QStringLiteral("authenticate\tinfo\tWelcome\n"
+                          "authenticate\techo-off\tPassword: \tsecret\n"
+                          "acct_mgmt\terror\tYour account expires tomorrow\n")
+        << QStringLiteral("alice") << true << int(Auth::HELPER_SUCCESS)
+        << QStringList { QStringLiteral("Welcome") }
+        << QStringList { QStringLiteral("Your account expires tomorrow") } << 0;
+
+    QTest::newRow("slow module")
+        << QStringLiteral("authenticate\tsleep\t300\n"
+                          "authenticate\techo-off\tPassword: \tsecret\n")
+        << QStringLiteral("alice") << true << int(Auth::HELPER_SUCCESS)
+        << QStringList() << QStringList() << 300;
+}
+
+void AuthTest::Conversation() {
+    QFETCH(QString, script);
+    QFETCH(QString, user);
+    QFETCH(bool, authenticated);
+    QFETCH(int, status);
+    QFETCH(QStringList, infos);
+    QFETCH(QStringList, errors);
+    QFETCH(int, minimumTime);
+
+    Result result = login(script, user, QStringLiteral("secret"), QStringLiteral("better"));
+
+    QCOMPARE(result.status, status);
+    QCOMPARE(result.authenticated, authenticated);
+    if (authenticated)
+        QCOMPARE(result.user, QStringLiteral("alice"));
+    QCOMPARE(result.infos, infos);
+    QCOMPARE(result.errors, errors);
+    QVERIFY(result.elapsed >= minimumTime);
+}
+
+void AuthTest::Benchmark() {
+    const QString script = QStringLiteral("authenticate\techo-off\tPassword: \tsecret\n");
+
+    Result result;
+    QBENCHMARK {
+        result = login(script, QStringLiteral("alice"), QStringLiteral("secret"), QString());
+    }
+    QCOMPARE(result.status, int(Auth::HELPER_SUCCESS));
+}
+
+void AuthTest::Pool() {
+    const QString script = QStringLiteral("authenticate\techo-off\tPassword: \tsecret\n");
+
+    QFile::remove(m_dir.path() + QStringLiteral("/spawned"));
+
+    HelperPool pool;
+    pool.setSize(1);
+    QTRY_COMPARE(pool.idle(), 1);
+    QTRY_COMPARE(spawned(), 1);
+
+    // the job goes to the waiting helper with START
+    Result result = login(script, QStringLiteral("alice"), QStringLiteral("secret"), QString(), &pool);
+    QCOMPARE(result.idleAfterStart, 0);
+    QCOMPARE(result.status, int(Auth::HELPER_SUCCESS));
+    QVERIFY(result.authenticated);
+    QCOMPARE(result.user, QStringLiteral("alice"));
+
+    // not replaced while the conversation is going on
+    QCOMPARE(result.spawnedAtRequest, 1);
+
+    // but once it's through, no helper was started for the login itself
+    QTRY_COMPARE(pool.idle(), 1);
+    QTRY_COMPARE(spawned(), 2);
+
+    // one that isn't verbose starts its own
+    result = login(script, QStringLiteral("alice"), QStringLiteral("secret"), QString());
+    QCOMPARE(result.status, int(Auth::HELPER_SUCCESS));
+    QCOMPARE(pool.idle(), 1);
+    QCOMPARE(spawned(), 3);
+}
+
+void AuthTest::PoolIdleTimeout() {
+    QFile::remove(m_dir.path() + QStringLiteral("/spawned"));
+
+    HelperPool pool;
+    pool.setSize(1);
+    QTRY_COMPARE(pool.idle(), 1);
+    QTRY_COMPARE(spawned(), 1);
+
+    // the idle helper is retired and replaced
+    pool.setIdleTimeout(1);
+    QTRY_VERIFY_WITH_TIMEOUT(spawned() > 1, 10000);
+    QCOMPARE(pool.idle(), 1);
+
+    // and the replacement still takes a job
+    Result result = login(QStringLiteral("authenticate\techo-off\tPassword: \tsecret\n"),
+                          QStringLiteral("alice"), QStringLiteral("secret"), QString(), &pool);
+    QCOMPARE(result.idleAfterStart, 0);
+    QCOMPARE(result.status, int(Auth::HELPER_SUCCESS));
+}
@@ -0,0 +1,64 @@
+/*
+ * Authentication pipeline tests against a mock PAM stack
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AUTHTEST_H
+#define AUTHTEST_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTemporaryDir>
+
+namespace SDDM {
+    class HelperPool;
+}
+
+class AuthTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void Conversation_data();
+    void Conversation();
+    void Benchmark();
+    void Pool();
+    void PoolIdleTimeout();
+
+private:
+    struct Result {
+        QString user { };
+        bool authenticated { false };
+        int status { -1 };
+        QStringList infos { };
+        QStringList errors { };
+        qint64 elapsed { 0 };
+        int idleAfterStart { -1 };
+        int spawnedAtRequest { -1 };
+    };
+
+    Result login(const QString &script, const QString &user,
+                 const QString &password, const QString &newPassword,
+                 HelperPool *pool = nullptr);
+    int spawned() const;
+
+    QTemporaryDir m_dir;
+};
+
+#endif // AUTHTEST_H
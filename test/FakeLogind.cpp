@@ -0,0 +1,107 @@
+/*
+ * Minimal logind stand-in for the seat tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FakeLogind.h"
+
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusMetaType>
+
+using namespace SDDM;
+
+static const QString LOGIN1_SERVICE = QStringLiteral("org.freedesktop.login1");
+static const QString LOGIN1_PATH = QStringLiteral("/org/freedesktop/login1");
+
+FakeSeat::FakeSeat(const QString &id, bool canGraphical, bool canTTY, QObject *parent)
+    : QObject(parent)
+    , m_canGraphical(canGraphical)
+    , m_canTTY(canTTY)
+    , m_id(id) {
+}
+
+QString FakeSeat::path() const {
+    return QStringLiteral("/org/freedesktop/login1/seat/%1").arg(m_id);
+}
+
+FakeLogind::FakeLogind(QObject *parent)
+    : QObject(parent)
+    // a connection of its own, so that calls and signals go through the bus
+    , m_bus(QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("fakelogind"))) {
+    qDBusRegisterMetaType<NamedSeatPath>();
+    qDBusRegisterMetaType<NamedSeatPathList>();
+}
+
+FakeLogind::~FakeLogind() {
+    m_bus.unregisterService(LOGIN1_SERVICE);
+    QDBusConnection::disconnectFromBus(QStringLiteral("fakelogind"));
+}
+
+bool FakeLogind::registerService() {
+    return m_bus.registerObject(LOGIN1_PATH, this, QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllSignals) &&
+           m_bus.registerService(LOGIN1_SERVICE);
+}
+
+void FakeLogind::addSeat(const QString &id, bool canGraphical, bool canTTY) {
+    FakeSeat *seat = new FakeSeat(id, canGraphical, canTTY, this);
+    m_seats.insert(id, seat);
+    m_bus.registerObject(seat->path(), seat, QDBusConnection::ExportAllProperties);
+    emit SeatNew(id, QDBusObjectPath(seat->path()));
+}
+
+void FakeLogind::removeSeat(const QString &id) {
+    FakeSeat *seat = m_seats.take(id);
+    if (!seat)
+        return;
+
+    m_bus.unregisterObject(seat->path());
+    emit SeatRemoved(id, QDBusObjectPath(seat->path()));
+    delete seat;
+}
+
+void FakeLogind::setCanGraphical(const QString &id, bool canGraphical) {
+    FakeSeat *seat = m_seats.value(id);
+    if (!seat)
+        return;
+
+    seat->m_canGraphical = canGraphical;
+
+    // like logind, announce the change on the properties interface
+    QVariantMap changed;
+    changed.insert(QStringLiteral("CanGraphical"), canGraphical);
+    QDBusMessage message = QDBusMessage::createSignal(seat->path(), QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                      QStringLiteral("PropertiesChanged"));
+    message << QStringLiteral("org.freedesktop.login1.Seat") << changed << QStringList();
+    m_bus.send(message);
+}
+
+void FakeLogind::setListFails(bool fails) {
+    m_listFails = fails;
+}
+
+NamedSeatPathList FakeLogind::ListSeats() {
+    NamedSeatPathList seats;
+    if (m_listFails) {
+        sendErrorReply(QDBusError::AccessDenied, QStringLiteral("Not today"));
+        return seats;
+    }
+
+    for (FakeSeat *seat : m_seats)
+        seats << NamedSeatPath { seat->id(), QDBusObjectPath(seat->path()) };
+    return seats;
+}
@@ -0,0 +1,85 @@
+/*
+ * Minimal logind stand-in for the seat tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FAKELOGIND_H
+#define FAKELOGIND_H
+
+#include "SeatWatcher.h"
+
+#include <QtCore/QMap>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusContext>
+
+class FakeSeat : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.login1.Seat")
+    Q_PROPERTY(QString Id READ id)
+    Q_PROPERTY(bool CanGraphical READ canGraphical)
+    Q_PROPERTY(bool CanTTY READ canTTY)
+public:
+    FakeSeat(const QString &id, bool canGraphical, bool canTTY, QObject *parent);
+
+    QString id() const { return m_id; }
+    bool canGraphical() const { return m_canGraphical; }
+    bool canTTY() const { return m_canTTY; }
+
+    QString path() const;
+
+    bool m_canGraphical;
+    bool m_canTTY;
+
+private:
+    QString m_id;
+};
+
+/**
+ * Owns org.freedesktop.login1 on its own connection to the session bus,
+ * with just the seat parts of the manager interface
+ */
+class FakeLogind : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.login1.Manager")
+public:
+    explicit FakeLogind(QObject *parent = nullptr);
+    ~FakeLogind();
+
+    bool registerService();
+
+    void addSeat(const QString &id, bool canGraphical, bool canTTY = false);
+    void removeSeat(const QString &id);
+    void setCanGraphical(const QString &id, bool canGraphical);
+    void setListFails(bool fails);
+
+public slots:
+    SDDM::NamedSeatPathList ListSeats();
+
+signals:
+    void SeatNew(const QString &id, const QDBusObjectPath &path);
+    void SeatRemoved(const QString &id, const QDBusObjectPath &path);
+
+private:
+    QDBusConnection m_bus;
+    QMap<QString, FakeSeat *> m_seats;
+    bool m_listFails { false };
+};
+
+#endif // FAKELOGIND_H
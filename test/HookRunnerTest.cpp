@@ -0,0 +1,146 @@
+/*
+ * Display hook runner tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "HookRunnerTest.h"
+#include "HookRunner.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+QTEST_MAIN(HookRunnerTest);
+
+// none of the tests depend on how fast the hooks run, they'd flake on
+// a loaded machine otherwise: the hooks leave files behind to show what
+// overlapped, and wait for files rather than sleep
+#define WAIT_TIMEOUT 30000
+
+static QString shell(const QString &script) {
+    return QStringLiteral("/bin/sh -c \"%1\"").arg(script);
+}
+
+static bool writeScript(const QString &path, const QByteArray &script) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return file.write(script) == script.size();
+}
+
+void HookRunnerTest::NoHooks() {
+    HookRunner runner;
+    QSignalSpy ready(&runner, SIGNAL(ready()));
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+
+    runner.addHook(QStringLiteral("empty"), QString(), 1000);
+    runner.start();
+    QVERIFY(runner.isRunning());
+
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+    QCOMPARE(ready.count(), 1);
+    QVERIFY(!runner.isRunning());
+}
+
+void HookRunnerTest::Order() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString log = dir.path() + QStringLiteral("/log");
+
+    // the first one is slower, the second must still wait for it
+    HookRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+    runner.addHook(QStringLiteral("first"), shell(QStringLiteral("sleep 0.2; echo first >> %1").arg(log)), WAIT_TIMEOUT);
+    runner.addHook(QStringLiteral("second"), shell(QStringLiteral("echo second >> %1").arg(log)), WAIT_TIMEOUT);
+    runner.start();
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+
+    QFile file(log);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("first\nsecond\n"));
+}
+
+void HookRunnerTest::Parallel() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // each hook notes it started, then waits for the others to have
+    // started too, which they only can if they run at the same time
+    const QString script = dir.path() + QStringLiteral("/hook");
+    QVERIFY(writeScript(script,
+        "touch \"$1/started.$2\"\n"
+        "n=0\n"
+        "while [ $(ls \"$1\" | grep -c '^started') -lt 3 ] && [ $n -lt 400 ]; do\n"
+        "    sleep 0.05; n=$((n + 1))\n"
+        "done\n"
+        "[ $(ls \"$1\" | grep -c '^started') -ge 3 ] && touch \"$1/overlapped.$2\"\n"));
+
+    HookRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+    for (int i = 0; i < 3; ++i)
+        runner.addHook(QStringLiteral("hook %1").arg(i), QStringLiteral("/bin/sh %1 %2 %3").arg(script).arg(dir.path()).arg(i),
+                       WAIT_TIMEOUT, HookRunner::Parallel);
+    runner.start();
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+
+    for (int i = 0; i < 3; ++i)
+        QVERIFY(QFile::exists(dir.path() + QStringLiteral("/overlapped.%1").arg(i)));
+}
+
+void HookRunnerTest::Timeout() {
+    HookRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+    runner.addHook(QStringLiteral("stuck"), QStringLiteral("sleep 300"), 200);
+
+    // killed long before it'd be done on its own
+    runner.start();
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+}
+
+void HookRunnerTest::NonBlocking() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString go = dir.path() + QStringLiteral("/go");
+
+    // the slow one runs until we let it go
+    HookRunner runner;
+    QSignalSpy ready(&runner, SIGNAL(ready()));
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+    runner.addHook(QStringLiteral("quick"), QStringLiteral("true"), WAIT_TIMEOUT);
+    runner.addHook(QStringLiteral("slow"), shell(QStringLiteral("while [ ! -e %1 ]; do sleep 0.05; done").arg(go)),
+                   WAIT_TIMEOUT, HookRunner::NonBlocking);
+    runner.start();
+
+    // ready once the blocking one is done, while the other one still runs
+    QVERIFY(ready.wait(WAIT_TIMEOUT));
+    QCOMPARE(finished.count(), 0);
+    QVERIFY(runner.isRunning());
+
+    QVERIFY(writeScript(go, QByteArray()));
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+    QCOMPARE(ready.count(), 1);
+}
+
+void HookRunnerTest::FailedToStart() {
+    HookRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(finished()));
+    runner.addHook(QStringLiteral("missing"), QStringLiteral("/nonexistent/hook"), WAIT_TIMEOUT);
+    runner.addHook(QStringLiteral("next"), QStringLiteral("true"), WAIT_TIMEOUT);
+    runner.start();
+    QVERIFY(finished.wait(WAIT_TIMEOUT));
+}
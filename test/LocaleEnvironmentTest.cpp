@@ -0,0 +1,128 @@
+/*
+ * locale.conf parsing tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LocaleEnvironmentTest.h"
+#include "LocaleEnvironment.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+QTEST_MAIN(LocaleEnvironmentTest);
+
+void LocaleEnvironmentTest::Parse_data() {
+    QTest::addColumn<QByteArray>("contents");
+    QTest::addColumn<QStringList>("variables");
+
+    // values
+    QTest::newRow("unquoted") << QByteArray("LANG=en_US.UTF-8\n")
+        << QStringList { QStringLiteral("LANG=en_US.UTF-8") };
+    QTest::newRow("double quoted") << QByteArray("LANG=\"en_US.UTF-8\"\n")
+        << QStringList { QStringLiteral("LANG=en_US.UTF-8") };
+    QTest::newRow("single quoted") << QByteArray("LANG='de_DE.UTF-8'\n")
+        << QStringList { QStringLiteral("LANG=de_DE.UTF-8") };
+    QTest::newRow("quoted spaces") << QByteArray("LANGUAGE=\" de : en \"\n")
+        << QStringList { QStringLiteral("LANGUAGE= de : en ") };
+    QTest::newRow("partly quoted") << QByteArray("LANG=en_US'.UTF-8'\n")
+        << QStringList { QStringLiteral("LANG=en_US.UTF-8") };
+    QTest::newRow("empty") << QByteArray("LANG=\n")
+        << QStringList { QStringLiteral("LANG=") };
+    QTest::newRow("empty quoted") << QByteArray("LANG=\"\"\n")
+        << QStringList { QStringLiteral("LANG=") };
+    QTest::newRow("no final newline") << QByteArray("LANG=C")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("crlf") << QByteArray("LANG=C\r\nLC_ALL=C\r\n")
+        << QStringList { QStringLiteral("LANG=C"), QStringLiteral("LC_ALL=C") };
+    QTest::newRow("utf-8") << QByteArray("LANG=\"fr_FR.UTF-8\"\nLC_PAPER=\"caf\xc3\xa9\"\n")
+        << QStringList { QStringLiteral("LANG=fr_FR.UTF-8"), QString::fromUtf8("LC_PAPER=caf\xc3\xa9") };
+    QTest::newRow("last one wins") << QByteArray("LANG=C\nLANG=de_DE.UTF-8\n")
+        << QStringList { QStringLiteral("LANG=de_DE.UTF-8") };
+
+    // escapes
+    QTest::newRow("escaped space") << QByteArray("LANG=en\\ US\n")
+        << QStringList { QStringLiteral("LANG=en US") };
+    QTest::newRow("escaped double quote") << QByteArray("LANG=\"a\\\"b\"\n")
+        << QStringList { QStringLiteral("LANG=a\"b") };
+    QTest::newRow("backslash in double quotes") << QByteArray("LANG=\"a\\b\"\n")
+        << QStringList { QStringLiteral("LANG=a\\b") };
+    QTest::newRow("backslash in single quotes") << QByteArray("LANG='a\\'\n")
+        << QStringList { QStringLiteral("LANG=a\\") };
+    QTest::newRow("continuation") << QByteArray("LANG=en_US\\\n.UTF-8\nLC_ALL=C\n")
+        << QStringList { QStringLiteral("LANG=en_US.UTF-8"), QStringLiteral("LC_ALL=C") };
+    QTest::newRow("quoted continuation") << QByteArray("LANG=\"en_US\\\n.UTF-8\"\n")
+        << QStringList { QStringLiteral("LANG=en_US.UTF-8") };
+    QTest::newRow("backslash at end of file") << QByteArray("LANG=C\\")
+        << QStringList { QStringLiteral("LANG=C\\") };
+    QTest::newRow("continuation at end of file") << QByteArray("LANG=C\\\n")
+        << QStringList { QStringLiteral("LANG=C") };
+
+    // comments
+    QTest::newRow("comment lines") << QByteArray("# LANG=C\n; LC_ALL=C\n  # indented\nLANG=de_DE.UTF-8\n")
+        << QStringList { QStringLiteral("LANG=de_DE.UTF-8") };
+    QTest::newRow("trailing comment") << QByteArray("LANG=C # the default\n")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("comment after quotes") << QByteArray("LANG=\"C\" #x\n")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("hash in value") << QByteArray("LANG=C#x\nLC_ALL=\"#\"\n")
+        << QStringList { QStringLiteral("LANG=C#x"), QStringLiteral("LC_ALL=#") };
+    QTest::newRow("blank lines") << QByteArray("\n\n  \n\tLANG=C\n\n")
+        << QStringList { QStringLiteral("LANG=C") };
+
+    // export
+    QTest::newRow("export") << QByteArray("export LANG=C\n")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("export tab") << QByteArray("export\tLC_ALL=\"C\"\n")
+        << QStringList { QStringLiteral("LC_ALL=C") };
+    QTest::newRow("exported name") << QByteArray("exportLANG=C\n")
+        << QStringList();
+
+    // malformed
+    QTest::newRow("no assignment") << QByteArray("LANG\nLC_ALL=C\n")
+        << QStringList { QStringLiteral("LC_ALL=C") };
+    QTest::newRow("invalid name") << QByteArray("LC-ALL=C\n1LANG=C\nLC_ALL=C\n")
+        << QStringList { QStringLiteral("LC_ALL=C") };
+    QTest::newRow("no name") << QByteArray("=C\nLANG=C\n")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("unterminated double quote") << QByteArray("LC_ALL=C\nLANG=\"de_DE\nLC_TIME=C\n")
+        << QStringList { QStringLiteral("LC_ALL=C") };
+    QTest::newRow("unterminated single quote") << QByteArray("LC_ALL=C\nLANG='de_DE\n")
+        << QStringList { QStringLiteral("LC_ALL=C") };
+    QTest::newRow("empty file") << QByteArray()
+        << QStringList();
+
+    // only locale variables
+    QTest::newRow("filtered") << QByteArray("PATH=/tmp\nLD_PRELOAD=evil.so\nLANGX=C\nLANG=C\n")
+        << QStringList { QStringLiteral("LANG=C") };
+    QTest::newRow("all locale variables") << QByteArray("LANG=C\nLANGUAGE=de:en\nLC_ALL=C\nLC_MESSAGES=C\nLC_=C\n")
+        << QStringList { QStringLiteral("LANG=C"), QStringLiteral("LANGUAGE=de:en"), QStringLiteral("LC_=C"),
+                         QStringLiteral("LC_ALL=C"), QStringLiteral("LC_MESSAGES=C") };
+    QTest::newRow("lower case") << QByteArray("lang=C\nlc_all=C\n")
+        << QStringList();
+}
+
+void LocaleEnvironmentTest::Parse() {
+    QFETCH(QByteArray, contents);
+    QFETCH(QStringList, variables);
+
+    QStringList result = LocaleEnvironment::parse(contents).toStringList();
+    result.sort();
+    variables.sort();
+    QCOMPARE(result, variables);
+}
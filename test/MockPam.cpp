@@ -0,0 +1,286 @@
+/*
+ * Scriptable stand-in for libpam, loaded into sddm-helper with LD_PRELOAD
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * The script is read from $SDDM_MOCK_PAM_SCRIPT, one step per line with
+ * tab separated fields:
+ *
+ *   <call> <step> [argument] [expected response]
+ *
+ * <call> is the PAM function the step belongs to: authenticate, acct_mgmt,
+ * chauthtok, setcred, open_session or close_session. Steps of a call run in
+ * order every time the call is made:
+ *
+ *   echo-on <message> [expected]   prompt with PAM_PROMPT_ECHO_ON
+ *   echo-off <message> [expected]  prompt with PAM_PROMPT_ECHO_OFF
+ *   info <message>                 PAM_TEXT_INFO message
+ *   error <message>                PAM_ERROR_MSG message
+ *   sleep <milliseconds>           a slow module
+ *   result <PAM_...>               return code of the call, PAM_SUCCESS by default
+ *
+ * A response differing from the expected one fails the call. The response
+ * to an echo-on prompt becomes PAM_USER if no user was given to pam_start.
+ */
+
+#include <security/pam_appl.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+struct MockStep {
+    std::string call;
+    std::string step;
+    std::string argument;
+    std::string expected;
+    bool hasExpected;
+};
+
+struct pam_handle {
+    std::string service;
+    std::string user;
+    std::string tty;
+    std::string display;
+    struct pam_conv conv;
+    std::vector<MockStep> script;
+    std::vector<std::string> env;
+};
+
+static const std::map<std::string, int> &resultCodes() {
+    static const std::map<std::string, int> codes {
+        { "PAM_SUCCESS", PAM_SUCCESS },
+        { "PAM_AUTH_ERR", PAM_AUTH_ERR },
+        { "PAM_USER_UNKNOWN", PAM_USER_UNKNOWN },
+        { "PAM_MAXTRIES", PAM_MAXTRIES },
+        { "PAM_NEW_AUTHTOK_REQD", PAM_NEW_AUTHTOK_REQD },
+        { "PAM_ACCT_EXPIRED", PAM_ACCT_EXPIRED },
+        { "PAM_PERM_DENIED", PAM_PERM_DENIED },
+        { "PAM_AUTHTOK_ERR", PAM_AUTHTOK_ERR },
+        { "PAM_CRED_ERR", PAM_CRED_ERR },
+        { "PAM_SESSION_ERR", PAM_SESSION_ERR },
+        { "PAM_SYSTEM_ERR", PAM_SYSTEM_ERR },
+    };
+    return codes;
+}
+
+static std::vector<MockStep> loadScript() {
+    std::vector<MockStep> script;
+
+    const char *path = getenv("SDDM_MOCK_PAM_SCRIPT");
+    if (!path)
+        return script;
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t'))
+            fields.push_back(field);
+        if (fields.size() < 2)
+            continue;
+
+        MockStep step { fields[0], fields[1], fields.size() > 2 ? fields[2] : std::string(),
+                        fields.size() > 3 ? fields[3] : std::string(), fields.size() > 3 };
+        script.push_back(step);
+    }
+
+    return script;
+}
+
+// one message per conversation, like most modules do
+static int converse(pam_handle_t *pamh, int style, const std::string &message, std::string *response) {
+    struct pam_message msg;
+    msg.msg_style = style;
+    msg.msg = message.c_str();
+    const struct pam_message *msgp = &msg;
+    struct pam_response *resp = nullptr;
+
+    int result = pamh->conv.conv(1, &msgp, &resp, pamh->conv.appdata_ptr);
+    if (result != PAM_SUCCESS)
+        return result;
+
+    if (resp) {
+        if (resp[0].resp) {
+            if (response)
+                *response = resp[0].resp;
+            memset(resp[0].resp, 0, strlen(resp[0].resp));
+            free(resp[0].resp);
+        }
+        free(resp);
+    }
+
+    return PAM_SUCCESS;
+}
+
+static int run(pam_handle_t *pamh, const std::string &call, int mismatch) {
+    int result = PAM_SUCCESS;
+
+    for (const MockStep &step : pamh->script) {
+        if (step.call != call)
+            continue;
+
+        if (step.step == "echo-on" || step.step == "echo-off") {
+            std::string response;
+            int style = step.step == "echo-on" ? PAM_PROMPT_ECHO_ON : PAM_PROMPT_ECHO_OFF;
+            int conv = converse(pamh, style, step.argument, &response);
+            if (conv != PAM_SUCCESS)
+                return PAM_CONV_ERR;
+            if (style == PAM_PROMPT_ECHO_ON && pamh->user.empty())
+                pamh->user = response;
+            if (step.hasExpected && response != step.expected)
+                return mismatch;
+        } else if (step.step == "info") {
+            converse(pamh, PAM_TEXT_INFO, step.argument, nullptr);
+        } else if (step.step == "error") {
+            converse(pamh, PAM_ERROR_MSG, step.argument, nullptr);
+        } else if (step.step == "sleep") {
+            long ms = atol(step.argument.c_str());
+            struct timespec ts { ms / 1000, (ms % 1000) * 1000000 };
+            nanosleep(&ts, nullptr);
+        } else if (step.step == "result") {
+            auto it = resultCodes().find(step.argument);
+            result = it != resultCodes().end() ? it->second : PAM_SYSTEM_ERR;
+        }
+    }
+
+    return result;
+}
+
+extern "C" {
+
+int pam_start(const char *service_name, const char *user, const struct pam_conv *pam_conversation, pam_handle_t **pamh) {
+    if (!service_name || !pam_conversation || !pamh)
+        return PAM_SYSTEM_ERR;
+
+    pam_handle_t *handle = new pam_handle;
+    handle->service = service_name;
+    handle->user = user ? user : "";
+    handle->conv = *pam_conversation;
+    handle->script = loadScript();
+    *pamh = handle;
+
+    return PAM_SUCCESS;
+}
+
+int pam_end(pam_handle_t *pamh, int pam_status) {
+    (void) pam_status;
+    delete pamh;
+    return PAM_SUCCESS;
+}
+
+int pam_authenticate(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "authenticate", PAM_AUTH_ERR);
+}
+
+int pam_acct_mgmt(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "acct_mgmt", PAM_PERM_DENIED);
+}
+
+int pam_chauthtok(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "chauthtok", PAM_AUTHTOK_ERR);
+}
+
+int pam_setcred(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "setcred", PAM_CRED_ERR);
+}
+
+int pam_open_session(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "open_session", PAM_SESSION_ERR);
+}
+
+int pam_close_session(pam_handle_t *pamh, int flags) {
+    (void) flags;
+    return run(pamh, "close_session", PAM_SESSION_ERR);
+}
+
+int pam_set_item(pam_handle_t *pamh, int item_type, const void *item) {
+    const char *value = static_cast<const char *>(item);
+    switch (item_type) {
+        case PAM_USER:
+            pamh->user = value ? value : "";
+            return PAM_SUCCESS;
+        case PAM_TTY:
+            pamh->tty = value ? value : "";
+            return PAM_SUCCESS;
+#ifdef PAM_XDISPLAY
+        case PAM_XDISPLAY:
+            pamh->display = value ? value : "";
+            return PAM_SUCCESS;
+#endif
+        default:
+            return PAM_BAD_ITEM;
+    }
+}
+
+int pam_get_item(const pam_handle_t *pamh, int item_type, const void **item) {
+    switch (item_type) {
+        case PAM_SERVICE:
+            *item = pamh->service.c_str();
+            return PAM_SUCCESS;
+        case PAM_USER:
+            *item = pamh->user.empty() ? nullptr : pamh->user.c_str();
+            return PAM_SUCCESS;
+        case PAM_TTY:
+            *item = pamh->tty.c_str();
+            return PAM_SUCCESS;
+        default:
+            *item = nullptr;
+            return PAM_BAD_ITEM;
+    }
+}
+
+const char *pam_strerror(pam_handle_t *pamh, int errnum) {
+    (void) pamh;
+    for (const auto &code : resultCodes()) {
+        if (code.second == errnum)
+            return code.first.c_str();
+    }
+    return "Unknown mock PAM error";
+}
+
+int pam_putenv(pam_handle_t *pamh, const char *name_value) {
+    pamh->env.push_back(name_value);
+    return PAM_SUCCESS;
+}
+
+char **pam_getenvlist(pam_handle_t *pamh) {
+    char **list = static_cast<char **>(calloc(pamh->env.size() + 1, sizeof(char *)));
+    for (size_t i = 0; i < pamh->env.size(); ++i)
+        list[i] = strdup(pamh->env[i].c_str());
+    return list;
+}
+
+}
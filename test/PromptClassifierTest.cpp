@@ -0,0 +1,149 @@
+/*
+ * PAM prompt classification tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PromptClassifierTest.h"
+#include "PromptClassifier.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+Q_DECLARE_METATYPE(AuthPrompt::Type)
+
+QTEST_MAIN(PromptClassifierTest);
+
+// messages as the modules send them, with their echo setting
+static void addPrompts() {
+    QTest::addColumn<QString>("message");
+    QTest::addColumn<bool>("hidden");
+    QTest::addColumn<AuthPrompt::Type>("type");
+
+    // pam_unix
+    QTest::newRow("unix login") << QStringLiteral("login:") << false << AuthPrompt::LOGIN_USER;
+    QTest::newRow("unix password") << QStringLiteral("Password: ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("unix current") << QStringLiteral("(current) UNIX password: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("unix current 2") << QStringLiteral("Current password: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("unix new") << QStringLiteral("New password: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("unix new 2") << QStringLiteral("Enter new UNIX password: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("unix repeat") << QStringLiteral("Retype new password: ") << true << AuthPrompt::CHANGE_REPEAT;
+    QTest::newRow("unix repeat 2") << QStringLiteral("Retype new UNIX password: ") << true << AuthPrompt::CHANGE_REPEAT;
+
+    // pam_sss
+    QTest::newRow("sss password") << QStringLiteral("Password: ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("sss current") << QStringLiteral("Current Password: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("sss new") << QStringLiteral("New Password: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("sss repeat") << QStringLiteral("Reenter new Password: ") << true << AuthPrompt::CHANGE_REPEAT;
+    QTest::newRow("sss first factor") << QStringLiteral("First Factor: ") << true << AuthPrompt::UNKNOWN;
+    QTest::newRow("sss second factor") << QStringLiteral("Second Factor: ") << true << AuthPrompt::UNKNOWN;
+
+    // pam_krb5
+    QTest::newRow("krb5 password") << QStringLiteral("Password for alice@EXAMPLE.COM: ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("krb5 current") << QStringLiteral("Current Kerberos password: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("krb5 new") << QStringLiteral("Enter new password: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("krb5 repeat") << QStringLiteral("Enter it again: ") << true << AuthPrompt::UNKNOWN;
+    QTest::newRow("krb5 user named new") << QStringLiteral("Password for newton@EXAMPLE.COM: ") << true << AuthPrompt::LOGIN_PASSWORD;
+
+    // pam_unix, translated
+    QTest::newRow("de password") << QStringLiteral("Passwort: ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("de current") << QStringLiteral("Aktuelles Passwort: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("de new") << QStringLiteral("Neues Passwort: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("de repeat") << QStringLiteral("Geben Sie das neue Passwort erneut ein: ") << true << AuthPrompt::CHANGE_REPEAT;
+    QTest::newRow("fr password") << QStringLiteral("Mot de passe : ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("fr current") << QStringLiteral("Mot de passe actuel : ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("fr new") << QStringLiteral("Nouveau mot de passe : ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("fr repeat") << QStringLiteral("Retapez le nouveau mot de passe : ") << true << AuthPrompt::CHANGE_REPEAT;
+    QTest::newRow("es password") << QStringLiteral("Contraseña: ") << true << AuthPrompt::LOGIN_PASSWORD;
+    QTest::newRow("es current") << QStringLiteral("Contraseña actual: ") << true << AuthPrompt::CHANGE_CURRENT;
+    QTest::newRow("es new") << QStringLiteral("Nueva contraseña: ") << true << AuthPrompt::CHANGE_NEW;
+    QTest::newRow("es repeat") << QStringLiteral("Vuelva a escribir la nueva contraseña: ") << true << AuthPrompt::CHANGE_REPEAT;
+
+    // nothing to go by
+    QTest::newRow("otp") << QStringLiteral("Verification code: ") << true << AuthPrompt::UNKNOWN;
+    QTest::newRow("passwordless word") << QStringLiteral("Passwords: ") << true << AuthPrompt::UNKNOWN;
+}
+
+void PromptClassifierTest::Prompts_data() {
+    addPrompts();
+}
+
+void PromptClassifierTest::Prompts() {
+    QFETCH(QString, message);
+    QFETCH(bool, hidden);
+    QFETCH(AuthPrompt::Type, type);
+
+    PromptClassifier classifier;
+    QCOMPARE(classifier.classifyPrompt(message, hidden), type);
+}
+
+void PromptClassifierTest::PasswordChange_data() {
+    QTest::addColumn<QString>("message");
+    QTest::addColumn<bool>("change");
+
+    QTest::newRow("unix") << QStringLiteral("Changing password for alice.") << true;
+    QTest::newRow("sss") << QStringLiteral("Password expired. Change your password now.") << true;
+    QTest::newRow("unix expiry warning") << QStringLiteral("Warning: your password will expire in 5 days") << false;
+    QTest::newRow("motd") << QStringLiteral("Last login: Mon Jan  4 10:00:00 2016") << false;
+    QTest::newRow("empty") << QString() << false;
+}
+
+void PromptClassifierTest::PasswordChange() {
+    QFETCH(QString, message);
+    QFETCH(bool, change);
+
+    PromptClassifier classifier;
+    QCOMPARE(classifier.isPasswordChange(message), change);
+}
+
+void PromptClassifierTest::CustomPatterns() {
+    PromptClassifier::Patterns patterns = PromptClassifier::defaultPatterns();
+    patterns.password << QStringLiteral("PIN");
+    patterns.repeat << QStringLiteral("once more");
+    PromptClassifier classifier(patterns);
+
+    QCOMPARE(classifier.classifyPrompt(QStringLiteral("Smartcard PIN: "), true), AuthPrompt::LOGIN_PASSWORD);
+    QCOMPARE(classifier.classifyPrompt(QStringLiteral("New PIN once more: "), true), AuthPrompt::CHANGE_REPEAT);
+    QCOMPARE(classifier.classifyPrompt(QStringLiteral("Password: "), true), AuthPrompt::LOGIN_PASSWORD);
+}
+
+void PromptClassifierTest::InvalidPattern() {
+    PromptClassifier::Patterns patterns = PromptClassifier::defaultPatterns();
+    patterns.password << QStringLiteral("(unbalanced");
+    PromptClassifier classifier(patterns);
+
+    // falls back to the built-in keywords
+    QCOMPARE(classifier.classifyPrompt(QStringLiteral("New password: "), true), AuthPrompt::CHANGE_NEW);
+}
+
+void PromptClassifierTest::Benchmark_data() {
+    addPrompts();
+}
+
+void PromptClassifierTest::Benchmark() {
+    QFETCH(QString, message);
+    QFETCH(bool, hidden);
+    QFETCH(AuthPrompt::Type, type);
+
+    PromptClassifier classifier;
+    AuthPrompt::Type result = AuthPrompt::NONE;
+    QBENCHMARK {
+        result = classifier.classifyPrompt(message, hidden);
+    }
+    QCOMPARE(result, type);
+}
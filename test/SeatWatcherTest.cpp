@@ -0,0 +1,136 @@
+/*
+ * logind seat enumeration tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SeatWatcherTest.h"
+#include "FakeLogind.h"
+#include "SeatWatcher.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+QTEST_MAIN(SeatWatcherTest);
+
+void SeatWatcherTest::NoLogind() {
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QSignalSpy failed(&watcher, SIGNAL(listFailed()));
+    QVERIFY(watcher.start());
+
+    // ServiceUnknown, the seat manager falls back to the configured seats
+    QVERIFY(failed.wait(2000));
+    QCOMPARE(added.count(), 0);
+}
+
+void SeatWatcherTest::ListSeats() {
+    FakeLogind logind;
+    logind.addSeat(QStringLiteral("seat0"), true);
+    logind.addSeat(QStringLiteral("seat1"), true);
+    logind.addSeat(QStringLiteral("seat2"), false);
+    QVERIFY(logind.registerService());
+
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QVERIFY(watcher.start());
+
+    QTRY_COMPARE(added.count(), 2);
+    QStringList seats = watcher.seats();
+    seats.sort();
+    QCOMPARE(seats, QStringList() << QStringLiteral("seat0") << QStringLiteral("seat1"));
+}
+
+void SeatWatcherTest::CanGraphical() {
+    FakeLogind logind;
+    logind.addSeat(QStringLiteral("seat1"), false);
+    QVERIFY(logind.registerService());
+
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QSignalSpy removed(&watcher, SIGNAL(seatRemoved(QString)));
+    QVERIFY(watcher.start());
+
+    // the driver of its card finished loading
+    QTest::qWait(200);
+    QCOMPARE(added.count(), 0);
+    logind.setCanGraphical(QStringLiteral("seat1"), true);
+    QVERIFY(added.wait(2000));
+    QCOMPARE(added.at(0).at(0).toString(), QStringLiteral("seat1"));
+
+    logind.setCanGraphical(QStringLiteral("seat1"), false);
+    QVERIFY(removed.wait(2000));
+    QCOMPARE(removed.at(0).at(0).toString(), QStringLiteral("seat1"));
+    QVERIFY(watcher.seats().isEmpty());
+}
+
+void SeatWatcherTest::Hotplug() {
+    FakeLogind logind;
+    logind.addSeat(QStringLiteral("seat0"), true);
+    QVERIFY(logind.registerService());
+
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QSignalSpy removed(&watcher, SIGNAL(seatRemoved(QString)));
+    QVERIFY(watcher.start());
+    QTRY_COMPARE(added.count(), 1);
+
+    // a USB multiseat dock was plugged in, and out again
+    logind.addSeat(QStringLiteral("seat-usb"), true);
+    QTRY_COMPARE(added.count(), 2);
+    QCOMPARE(added.at(1).at(0).toString(), QStringLiteral("seat-usb"));
+
+    logind.removeSeat(QStringLiteral("seat-usb"));
+    QVERIFY(removed.wait(2000));
+    QCOMPARE(removed.at(0).at(0).toString(), QStringLiteral("seat-usb"));
+    QCOMPARE(watcher.seats(), QStringList() << QStringLiteral("seat0"));
+}
+
+void SeatWatcherTest::CanTTY() {
+    FakeLogind logind;
+    logind.addSeat(QStringLiteral("seat0"), true, true);
+    logind.addSeat(QStringLiteral("seat1"), true, false);
+    QVERIFY(logind.registerService());
+
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QVERIFY(watcher.start());
+    QTRY_COMPARE(added.count(), 2);
+
+    QHash<QString, bool> canTTY;
+    for (const QList<QVariant> &arguments : added)
+        canTTY.insert(arguments.at(0).toString(), arguments.at(1).toBool());
+    QCOMPARE(canTTY.value(QStringLiteral("seat0")), true);
+    QCOMPARE(canTTY.value(QStringLiteral("seat1")), false);
+}
+
+void SeatWatcherTest::ListFailed() {
+    FakeLogind logind;
+    logind.addSeat(QStringLiteral("seat0"), true, true);
+    logind.setListFails(true);
+    QVERIFY(logind.registerService());
+
+    SeatWatcher watcher(QDBusConnection::sessionBus());
+    QSignalSpy added(&watcher, SIGNAL(seatAdded(QString,bool)));
+    QSignalSpy failed(&watcher, SIGNAL(listFailed()));
+    QVERIFY(watcher.start());
+
+    // the seat manager falls back to the configured seats
+    QVERIFY(failed.wait(2000));
+    QCOMPARE(added.count(), 0);
+}
@@ -0,0 +1,157 @@
+/*
+ * Session log rotation tests
+ * Copyright (C) 2016 The SDDM Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SessionLogTest.h"
+#include "SessionLog.h"
+
+#include <QtTest/QtTest>
+
+#include <unistd.h>
+
+using namespace SDDM;
+
+QTEST_MAIN(SessionLogTest);
+
+static void writeFile(const QString &path, const QByteArray &data) {
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+static QByteArray readFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+static void writeFd(int fd, const QByteArray &data) {
+    QCOMPARE(::write(fd, data.constData(), data.size()), ssize_t(data.size()));
+}
+
+void SessionLogTest::KeepsPrevious() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/session.log");
+    writeFile(path, "old\n");
+
+    SessionLog log(path, 0, 2);
+    int fd = log.start();
+    QVERIFY(fd >= 0);
+    writeFd(fd, "new\n");
+    ::close(fd);
+
+    QCOMPARE(readFile(path), QByteArray("new\n"));
+    QCOMPARE(readFile(path + QStringLiteral(".1")), QByteArray("old\n"));
+    QVERIFY(!QFile::exists(path + QStringLiteral(".2")));
+}
+
+void SessionLogTest::DropsOldest() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/session.log");
+    writeFile(path, "third\n");
+    writeFile(path + QStringLiteral(".1"), "second\n");
+    writeFile(path + QStringLiteral(".2"), "first\n");
+
+    SessionLog log(path, 0, 2);
+    int fd = log.start();
+    QVERIFY(fd >= 0);
+    ::close(fd);
+
+    QCOMPARE(readFile(path), QByteArray());
+    QCOMPARE(readFile(path + QStringLiteral(".1")), QByteArray("third\n"));
+    QCOMPARE(readFile(path + QStringLiteral(".2")), QByteArray("second\n"));
+    QVERIFY(!QFile::exists(path + QStringLiteral(".3")));
+}
+
+void SessionLogTest::NoKeep() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/session.log");
+    writeFile(path, "old\n");
+
+    SessionLog log(path, 0, 0);
+    int fd = log.start();
+    QVERIFY(fd >= 0);
+    ::close(fd);
+
+    QCOMPARE(readFile(path), QByteArray());
+    QVERIFY(!QFile::exists(path + QStringLiteral(".1")));
+}
+
+void SessionLogTest::SizeCap() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/session.log");
+    const QString rotated = path + QStringLiteral(".1");
+
+    SessionLog log(path, 100, 1);
+    int fd = log.start();
+    QVERIFY(fd >= 0);
+
+    // each write is waited for, the writer would read them as one otherwise
+    writeFd(fd, QByteArray(60, 'a'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'a'));
+
+    writeFd(fd, QByteArray(60, 'b'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'b'));
+    QCOMPARE(readFile(rotated), QByteArray(60, 'a'));
+
+    writeFd(fd, QByteArray(60, 'c'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'c'));
+    QCOMPARE(readFile(rotated), QByteArray(60, 'b'));
+    QVERIFY(!QFile::exists(path + QStringLiteral(".2")));
+
+    ::close(fd);
+}
+
+void SessionLogTest::SharedLog() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/session.log");
+    const QString rotated = path + QStringLiteral(".1");
+
+    SessionLog first(path, 100, 1);
+    int firstFd = first.start();
+    QVERIFY(firstFd >= 0);
+    writeFd(firstFd, QByteArray(60, 'a'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'a'));
+
+    // the next login, while the first session's writer still runs
+    SessionLog second(path, 100, 1);
+    int secondFd = second.start();
+    QVERIFY(secondFd >= 0);
+    QCOMPARE(readFile(rotated), QByteArray(60, 'a'));
+
+    // the first writer finds its log rotated away, and carries on in the
+    // new one rather than rotating that
+    writeFd(firstFd, QByteArray(60, 'b'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'b'));
+    QCOMPARE(readFile(rotated), QByteArray(60, 'a'));
+
+    // the second one goes by the size of the shared log
+    writeFd(secondFd, QByteArray(60, 'c'));
+    QTRY_COMPARE(readFile(path), QByteArray(60, 'c'));
+    QCOMPARE(readFile(rotated), QByteArray(60, 'b'));
+
+    ::close(firstFd);
+    ::close(secondFd);
+}